@@ -3,6 +3,9 @@
 //      Given checker pieces never exists on white squares, this assignment
 //      sections the uint64_t int Bitboard nto bits (0-31, 32-63)
 //
+//      The engine itself, built as libcheckers. Only what checkers.h
+//      declares is exported, main.c is the command line front end.
+//
 // - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
 
 #include <stdio.h>
@@ -11,6 +14,14 @@
 #include <string.h>
 #include <ctype.h>
 #include <time.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <math.h>
+#include "checkers.h"
 
 typedef uint64_t Bitboard;
 
@@ -19,51 +30,149 @@ void SetBit(Bitboard *board, int pos) {
     *board |= (1ULL << pos);
 }
 
-void ClearBit(Bitboard *board, int pos) {
-    *board &= ~(1ULL << pos);
+int CountBits(Bitboard board) {
+    return __builtin_popcountll(board);
 }
 
-int GetBit(Bitboard board, int pos) {
-    return (board >> pos) & 1;
+double NowSeconds() {                   // Monotonic wall clock for budgets and benchmarks
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
 }
 
-int CountBits(Bitboard board) {
-    return __builtin_popcountll(board);
+
+// Implementations
+typedef CheckersGame GameState;         // Positions and moves are the public structs from checkers.h
+typedef CheckersMove Move;
+
+#define MAX_HOPS    CHECKERS_MAX_HOPS
+#define MAX_MOVES   CHECKERS_MAX_MOVES
+
+// Square tables
+// Geometry of the 32 playable squares (bit = row * 4 + col / 2, even rows start on column b), all
+// worked out by the compiler from the square number. Steps that leave the board give NO_SQUARE.
+#define NO_SQUARE   32
+
+enum { UP_LEFT, UP_RIGHT, DOWN_LEFT, DOWN_RIGHT };      // Order of the direction columns, 3 - dir is the reverse
+
+#define SQUARE_ROW(s)           ((s) / 4)
+#define SQUARE_COL(s)           ((s) % 4 * 2 + (SQUARE_ROW(s) % 2 == 0))
+#define SQUARE_AT(row, col)     ((row) >= 0 && (row) < 8 && (col) >= 0 && (col) < 8 ? (row) * 4 + (col) / 2 : NO_SQUARE)
+#define SQUARE_STEP(s, n, dir)  SQUARE_AT(SQUARE_ROW(s) + ((dir) >= DOWN_LEFT ? (n) : -(n)), SQUARE_COL(s) + ((dir) % 2 ? (n) : -(n)))
+#define SQUARE_OVER(s, dir)     (SQUARE_STEP(s, 2, dir) != NO_SQUARE ? SQUARE_STEP(s, 1, dir) : NO_SQUARE)
+
+#define NEIGHBOURS(s)   {SQUARE_STEP(s, 1, 0), SQUARE_STEP(s, 1, 1), SQUARE_STEP(s, 1, 2), SQUARE_STEP(s, 1, 3)}
+#define JUMPS_OVER(s)   {SQUARE_OVER(s, 0), SQUARE_OVER(s, 1), SQUARE_OVER(s, 2), SQUARE_OVER(s, 3)}
+#define LANDINGS(s)     {SQUARE_STEP(s, 2, 0), SQUARE_STEP(s, 2, 1), SQUARE_STEP(s, 2, 2), SQUARE_STEP(s, 2, 3)}
+#define DARK_SQUARE(row, col)   (((row) + (col)) % 2 == 1 ? SQUARE_AT(row, col) : NO_SQUARE)
+#define BOARD_ROW(r)    {DARK_SQUARE(r, 0), DARK_SQUARE(r, 1), DARK_SQUARE(r, 2), DARK_SQUARE(r, 3), \
+                         DARK_SQUARE(r, 4), DARK_SQUARE(r, 5), DARK_SQUARE(r, 6), DARK_SQUARE(r, 7)}
+#define ROW_SQUARES(m, r)   m(r * 4), m(r * 4 + 1), m(r * 4 + 2), m(r * 4 + 3)
+#define ALL_SQUARES(m)  ROW_SQUARES(m, 0), ROW_SQUARES(m, 1), ROW_SQUARES(m, 2), ROW_SQUARES(m, 3), \
+                        ROW_SQUARES(m, 4), ROW_SQUARES(m, 5), ROW_SQUARES(m, 6), ROW_SQUARES(m, 7)
+
+static const uint8_t square_row[32] = {ALL_SQUARES(SQUARE_ROW)};
+static const uint8_t square_col[32] = {ALL_SQUARES(SQUARE_COL)};
+static const uint8_t square_neighbour[32][4] = {ALL_SQUARES(NEIGHBOURS)};      // [square][dir]
+static const uint8_t square_jump_over[32][4] = {ALL_SQUARES(JUMPS_OVER)};      // NO_SQUARE if the landing is off the board
+static const uint8_t square_landing[32][4] = {ALL_SQUARES(LANDINGS)};
+static const uint8_t board_square[8][8] = {BOARD_ROW(0), BOARD_ROW(1), BOARD_ROW(2), BOARD_ROW(3),
+                                           BOARD_ROW(4), BOARD_ROW(5), BOARD_ROW(6), BOARD_ROW(7)};     // NO_SQUARE on light squares
+static const uint32_t promotion_rows[2] = {0x0000000FU, 0xF0000000U};          // Red kings on row 8, black on row 1
+static const uint8_t forward_dirs[2] = {1 << UP_LEFT | 1 << UP_RIGHT, 1 << DOWN_LEFT | 1 << DOWN_RIGHT};     // Directions men may go
+
+int board_to_bitpos(int row, int col) {     // shifts map coordinates
+    return board_square[row][col];
+}
+
+void bitpos_to_board(int bit_pos, int *row, int *col) {     // Reverse of board_to_bitpos
+    *row = square_row[bit_pos];
+    *col = square_col[bit_pos];
 }
 
+// Zobrist hashing
+// One random number per bit of pieces and kings plus one for black to move. Flipping a bit in the
+// boards flips the same number into the key, so moves update it with a few xors.
+uint64_t zobrist_pieces[64];
+uint64_t zobrist_kings[64];
+uint64_t zobrist_turn;
+
+uint64_t SplitMix64(uint64_t *state) {      // Small fixed-seed generator so keys match between runs
+    uint64_t z = (*state += 0x9E3779B97F4A7C15ULL);
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+    return z ^ (z >> 31);
+}
 
-// Display functions
-void PrintBinary(Bitboard board) {      // Show in binary
-    printf("Binary: ");
-    for (int i = 63; i >= 0; i--) {
-        printf("%d", GetBit(board, i));
-        if (i % 8 == 0) printf(" ");
+void InitZobrist() {
+    uint64_t seed = 0x436865636B657273ULL;
+    for (int i = 0; i < 64; i++) {
+        zobrist_pieces[i] = SplitMix64(&seed);
+        zobrist_kings[i] = SplitMix64(&seed);
     }
-    printf("\n");
+    zobrist_turn = SplitMix64(&seed);
 }
 
-void PrintHex(Bitboard board) {         // Show in hex
-    printf("Hex: 0x%016llX\n", board);
+uint64_t ComputeKey(GameState *game) {      // Full recompute, moves update the key incrementally
+    uint64_t key = game->current_turn ? zobrist_turn : 0;
+    for (Bitboard b = game->pieces; b; b &= b - 1) {
+        key ^= zobrist_pieces[__builtin_ctzll(b)];
+    }
+    for (Bitboard b = game->kings; b; b &= b - 1) {
+        key ^= zobrist_kings[__builtin_ctzll(b)];
+    }
+    return key;
 }
 
+// Incremental state
+// Besides the key, every position carries its piece counts and a weighted sum over its bits: each bit
+// of pieces is worth piece (a man on that square) and each bit of kings adds king on top. Both are
+// plain sums over bits, so a move only has to look at the bits it flips. They come from the first three
+// evaluation weights, the rest are worked out from the boards (see Evaluation). GameState.eval is kept
+// with the default weights; a search with other weights works its root out again and carries on with those.
+enum { EVAL_MEN, EVAL_KINGS, EVAL_ADVANCE, EVAL_BACK_RANK, EVAL_CENTRE, EVAL_MOBILITY, EVAL_RUNAWAY, EVAL_FEATURES };
+_Static_assert(EVAL_FEATURES == CHECKERS_EVAL_FEATURES, "CheckersWeights has one value per feature");
 
-// Implementations
 typedef struct {
-    Bitboard pieces;
-    Bitboard kings;
-    int current_turn;
-} GameState;
+    int weights[EVAL_FEATURES];         // Same order as the features
+    int piece[64];                      // From red's side, black's weights are negative
+    int king[64];
+} EvalWeights;
 
-typedef struct {                // Used to calculate the shifts
-    int from_row, from_col;
-    int to_row, to_col;
-    int capture_row, capture_col;
-} Move;
+static const int default_values[EVAL_FEATURES] = {100, 130, 2, 6, 3, 2, 25};
+static const char *eval_names[EVAL_FEATURES] = {"men", "kings", "advance", "back_rank", "centre", "mobility", "runaway"};
+EvalWeights default_weights;            // Filled once by CheckersInit, read only after that
 
-int board_to_bitpos(int row, int col) {     // shifts map coordinates
-    int bit_row = row;
-    int bit_pos = bit_row * 4 + (col / 2);
-    return bit_pos;
+void InitWeights(EvalWeights *eval, const int weights[EVAL_FEATURES]) {
+    memcpy(eval->weights, weights, sizeof(eval->weights));
+    for (int bit = 0; bit < 64; bit++) {
+        int row = bit % 32 / 4, sign = bit < 32 ? 1 : -1;
+        int advance = bit < 32 ? 7 - row : row;         // Red advances toward row 0, black toward row 7
+        eval->piece[bit] = sign * (weights[EVAL_MEN] + weights[EVAL_ADVANCE] * advance);
+        eval->king[bit] = sign * weights[EVAL_KINGS] - eval->piece[bit];
+    }
+}
+
+int MaterialEval(const GameState *game, const EvalWeights *eval) {      // What GameState.eval holds under these weights
+    int score = 0;
+    for (Bitboard b = game->pieces; b; b &= b - 1) {
+        score += eval->piece[__builtin_ctzll(b)];
+    }
+    for (Bitboard b = game->kings; b; b &= b - 1) {
+        score += eval->king[__builtin_ctzll(b)];
+    }
+    return score;
+}
+
+void ComputeState(GameState *game) {        // Full recompute of the key, counts and eval after setting the boards
+    game->key = ComputeKey(game);
+    game->reversible = 0;       // Nothing known about the moves before
+    game->eval = MaterialEval(game, &default_weights);
+    for (int player = 0; player < 2; player++) {
+        uint32_t kings = (uint32_t)(game->kings >> (32 * player));
+        game->material[player][0] = __builtin_popcount((uint32_t)(game->pieces >> (32 * player)) & ~kings);
+        game->material[player][1] = __builtin_popcount(kings);
+    }
 }
 
 void InitializeGame(GameState *game) {
@@ -88,525 +197,3213 @@ void InitializeGame(GameState *game) {
             }
         }
     }
+    ComputeState(game);
 }
 
-void PrintBoard(GameState *game) {
-    printf("\n    a   b   c   d   e   f   g   h\n");
-    printf("  ┏━━━┳━━━┳━━━┳━━━┳━━━┳━━━┳━━━┳━━━┓\n");
-    
-    for (int row = 0; row < 8; row++) {
-        printf("%d ┃", 8 - row);
-        for (int col = 0; col < 8; col++) {
-            int bit_pos = board_to_bitpos(row, col);            // Converts coords to bit pos
-            int is_red = GetBit(game->pieces, bit_pos);
-            int is_black = GetBit(game->pieces, bit_pos + 32);      // Offset for condensed 64 bit
-            int is_king = GetBit(game->kings, bit_pos) || GetBit(game->kings, bit_pos + 32);
-            
-            char piece = ' ';
-            if (is_red) {                               // Most effecient labeling
-                piece = is_king ? 'R' : 'r';           
-            } else if (is_black) {
-                piece = is_king ? 'B' : 'b';
-            }
-            
-            if ((row + col) % 2 == 0) {                 // Print the board grid
-                printf("▓▓▓┃");
-            } else {
-                if (piece == ' ') {
-                    printf("   ┃");
-                } else {
-                    printf(" %c ┃", piece);
-                }
-            }
-        }
-        printf(" %d\n", 8 - row);
-        
-        if (row < 7) {
-            printf("  ┣━━━╋━━━╋━━━╋━━━╋━━━╋━━━╋━━━╋━━━┫\n");
-        }
+int IsValidPosition(int row, int col) {         // Checks the row and column for playable black square
+    return row >= 0 && row < 8 && col >= 0 && col < 8 && board_square[row][col] != NO_SQUARE;
+}
+
+
+// Whole-board move generation
+// Each color is a 32 bit half of the board (bit = row * 4 + col / 2), so a diagonal step is a shift.
+// Even rows are offset one column right of odd rows, which makes the shift depend on the row parity:
+//   even row: up-left -4, up-right -3, down-left +4, down-right +5
+//   odd row:  up-left -5, up-right -4, down-left +3, down-right +4
+#define EVEN_ROWS   0x0F0F0F0FU
+#define ODD_ROWS    0xF0F0F0F0U
+#define LEFT_SLOT   0x11111111U     // col / 2 == 0
+#define RIGHT_SLOT  0x88888888U     // col / 2 == 3
+
+static inline uint32_t Step(uint32_t b, int dir) {     // Moves every bit one square, dropping the ones that fall off
+    switch (dir) {
+        case UP_LEFT:    return ((b & EVEN_ROWS) >> 4) | ((b & ODD_ROWS & ~LEFT_SLOT) >> 5);
+        case UP_RIGHT:   return ((b & EVEN_ROWS & ~RIGHT_SLOT) >> 3) | ((b & ODD_ROWS) >> 4);
+        case DOWN_LEFT:  return ((b & EVEN_ROWS) << 4) | ((b & ODD_ROWS & ~LEFT_SLOT) << 3);
+        default:         return ((b & EVEN_ROWS & ~RIGHT_SLOT) << 5) | ((b & ODD_ROWS) << 4);
     }
-    printf("  ┗━━━┻━━━┻━━━┻━━━┻━━━┻━━━┻━━━┻━━━┛\n");
-    printf("    a   b   c   d   e   f   g   h\n");
 }
 
-int IsValidPosition(int row, int col) {         // Checks the row and column for playable black square
-    return row >= 0 && row < 8 && col >= 0 && col < 8 && (row + col) % 2 == 1;
+static inline uint32_t SideBits(Bitboard board, int player) {      // Red is the low half, black the high half
+    return (uint32_t)(board >> (32 * player));
 }
 
-int GetPieceAt(GameState *game, int row, int col) {     // Returns 0 (red), 1 (black), empty for row column
-    if (!IsValidPosition(row, col)) return -1;
-    
-    int bit_pos = board_to_bitpos(row, col);
-    if (GetBit(game->pieces, bit_pos)) return 0;
-    if (GetBit(game->pieces, bit_pos + 32)) return 1;
-    return -1;
+static inline uint32_t EmptySquares(GameState *game) {
+    return ~(SideBits(game->pieces, 0) | SideBits(game->pieces, 1));
 }
 
-int IsKing(GameState *game, int row, int col) {         // Checks the kings board for a king
-    if (!IsValidPosition(row, col)) return 0;
-    
-    int bit_pos = board_to_bitpos(row, col);
-    return GetBit(game->kings, bit_pos) || GetBit(game->kings, bit_pos + 32);
+static inline uint32_t MoversFor(GameState *game, int player, int dir) {      // Men only go forward, kings go anywhere
+    uint32_t own = SideBits(game->pieces, player);
+    int forward = (player == 0) ? (dir == UP_LEFT || dir == UP_RIGHT) : (dir == DOWN_LEFT || dir == DOWN_RIGHT);
+    return forward ? own : own & SideBits(game->kings, player);
 }
 
-int CanPieceCapture(GameState *game, int row, int col) {    // Can the given piece jump over opposite piece
-    int player = GetPieceAt(game, row, col);
-    if (player == -1) return 0;     // End if there is no piece
-    
-    int is_king = IsKing(game, row, col);
-    int directions[4][2] = {{-1, -1}, {-1, 1}, {1, -1}, {1, 1}};        // Kings move in all corners
-    
-    for (int i = 0; i < 4; i++) {
-        int drow = directions[i][0];
-        int dcol = directions[i][1];
-        
-        if (!is_king) {         // Move orientation of colors
-            if (player == 0 && drow >= 0) continue;
-            if (player == 1 && drow <= 0) continue;
-        }
-        
-        int jump_row = row + drow;
-        int jump_col = col + dcol;
-        int land_row = row + 2 * drow;
-        int land_col = col + 2 * dcol;
-        
-        if (IsValidPosition(jump_row, jump_col) && IsValidPosition(land_row, land_col)) {
-            int jump_player = GetPieceAt(game, jump_row, jump_col);
-            int land_player = GetPieceAt(game, land_row, land_col);
-            
-            if (jump_player == 1 - player && land_player == -1) {       // Jump must have opponent and empty land
-                return 1;
-            }
-        }
+uint32_t GetJumpers(GameState *game, int player) {      // Every piece that has a capture available
+    uint32_t opp = SideBits(game->pieces, 1 - player);
+    uint32_t empty = EmptySquares(game);
+    uint32_t jumpers = 0;
+
+    for (int dir = 0; dir < 4; dir++) {     // Walk back from empty landings over opponents
+        jumpers |= MoversFor(game, player, dir) & Step(Step(empty, 3 - dir) & opp, 3 - dir);
     }
-    return 0;
+    return jumpers;
 }
 
-int HasForcedCapture(GameState *game, int player) {
-    for (int row = 0; row < 8; row++) {
-        for (int col = 0; col < 8; col++) {
-            if (GetPieceAt(game, row, col) == player) {
-                if (CanPieceCapture(game, row, col)) {
-                    return 1;
-                }
-            }
-        }
+uint32_t GetMovers(GameState *game, int player) {       // Every piece that has a single diagonal move
+    uint32_t empty = EmptySquares(game);
+    uint32_t movers = 0;
+
+    for (int dir = 0; dir < 4; dir++) {
+        movers |= MoversFor(game, player, dir) & Step(empty, 3 - dir);
     }
-    return 0;
+    return movers;
 }
 
-void GetPossibleMoves(GameState *game, int row, int col, Move moves[], int *move_count, int must_capture) {
-    *move_count = 0;
-    int player = GetPieceAt(game, row, col);
-    if (player == -1) return;
-    
-    int is_king = IsKing(game, row, col);
-    int directions[4][2] = {{-1, -1}, {-1, 1}, {1, -1}, {1, 1}};
-    int has_capture = 0;
-    
-    for (int i = 0; i < 4; i++) {
-        int drow = directions[i][0];
-        int dcol = directions[i][1];
-        
-        if (!is_king) {
-            if (player == 0 && drow >= 0) continue;
-            if (player == 1 && drow <= 0) continue;
-        }
-        
-        int jump_row = row + drow;
-        int jump_col = col + dcol;
-        int land_row = row + 2 * drow;
-        int land_col = col + 2 * dcol;
+void StartMove(Move *move, int from) {
+    move->from = from;
+    bitpos_to_board(from, &move->from_row, &move->from_col);
+    move->capture_row = -1;
+    move->capture_col = -1;
+    move->captures = 0;
+    move->hops = 0;
+}
+
+void AddHop(Move *move, int to, int capture) {      // capture is -1 for a quiet step
+    if (capture >= 0) {
+        if (!move->captures) bitpos_to_board(capture, &move->capture_row, &move->capture_col);
+        move->captures |= 1U << capture;
+    }
+    move->path[move->hops++] = to;
+    move->to = to;
+    bitpos_to_board(to, &move->to_row, &move->to_col);
+}
+
+static inline int PromotesOn(int player, int square) {
+    return (promotion_rows[player] >> square) & 1;
+}
+
+// Follows a jump sequence from square, adding a move for every way it can end. Jumped pieces come off as
+// they're taken, so empty and opp change along the way, and a man that reaches the far row stops there.
+static void GenerateJumps(int player, int king, int square, uint32_t opp, uint32_t empty,
+                          Move *move, Move moves[], int *count) {
+    int extended = 0;
+    int dirs = king ? 0xF : forward_dirs[player];
+    for (int dir = 0; dir < 4; dir++) {
+        int over = square_jump_over[square][dir];
+        if (!((dirs >> dir) & 1) || over == NO_SQUARE || !((opp >> over) & 1)) continue;
+        int to = square_landing[square][dir];
+        if (!((empty >> to) & 1)) continue;
         
-        if (IsValidPosition(jump_row, jump_col) && IsValidPosition(land_row, land_col)) {
-            int jump_player = GetPieceAt(game, jump_row, jump_col);
-            int land_player = GetPieceAt(game, land_row, land_col);
-            
-            if (jump_player == 1 - player && land_player == -1) {       // Adds this as a capture move
-                has_capture = 1;
-                moves[*move_count].from_row = row;
-                moves[*move_count].from_col = col;
-                moves[*move_count].to_row = land_row;
-                moves[*move_count].to_col = land_col;
-                moves[*move_count].capture_row = jump_row;
-                moves[*move_count].capture_col = jump_col;
-                (*move_count)++;
-            }
+        Move next = *move;
+        AddHop(&next, to, over);
+        extended = 1;
+        if (!king && PromotesOn(player, to)) {          // Kinging ends the move
+            if (*count == MAX_MOVES) return;
+            moves[(*count)++] = next;
+        } else {
+            GenerateJumps(player, king, to, opp & ~(1U << over), (empty | 1U << over | 1U << square) & ~(1U << to),
+                          &next, moves, count);
         }
     }
-    
-    if (has_capture && must_capture) {
-        return;
+    if (!extended && move->hops > 0 && *count < MAX_MOVES) moves[(*count)++] = *move;
+}
+
+int GenerateMoves(GameState *game, int player, Move moves[]) {     // All legal moves, only captures when one exists
+    uint32_t opp = SideBits(game->pieces, 1 - player);
+    uint32_t kings = SideBits(game->kings, player);
+    uint32_t empty = EmptySquares(game);
+    int count = 0;
+
+    for (uint32_t jumpers = GetJumpers(game, player); jumpers; jumpers &= jumpers - 1) {
+        int from = __builtin_ctz(jumpers);
+        Move move;
+        StartMove(&move, from);
+        GenerateJumps(player, (kings >> from) & 1, from, opp, empty, &move, moves, &count);
     }
-    
-    if (!has_capture || !must_capture) {
-        for (int i = 0; i < 4; i++) {
-            int drow = directions[i][0];
-            int dcol = directions[i][1];
-            
-            if (!is_king) {
-                if (player == 0 && drow >= 0) continue;
-                if (player == 1 && drow <= 0) continue;
-            }
-            
-            int new_row = row + drow;
-            int new_col = col + dcol;
-            
-            if (IsValidPosition(new_row, new_col) && GetPieceAt(game, new_row, new_col) == -1) {        // Now checks for single diagonal moves
-                moves[*move_count].from_row = row;
-                moves[*move_count].from_col = col;
-                moves[*move_count].to_row = new_row;
-                moves[*move_count].to_col = new_col;
-                moves[*move_count].capture_row = -1;
-                moves[*move_count].capture_col = -1;
-                (*move_count)++;
-            }
+    if (count > 0) return count;        // Captures are mandatory
+
+    for (int dir = 0; dir < 4; dir++) {
+        uint32_t land = Step(MoversFor(game, player, dir), dir) & empty;
+        while (land) {
+            int to = __builtin_ctz(land);
+            StartMove(&moves[count], __builtin_ctz(Step(1U << to, 3 - dir)));
+            AddHop(&moves[count++], to, -1);
+            land &= land - 1;
         }
     }
+    return count;
 }
 
-int IsValidMove(GameState *game, int from_row, int from_col, int to_row, int to_col) {
-    int player = GetPieceAt(game, from_row, from_col);      // Finds starting position
-    if (player == -1 || player != game->current_turn) return 0;
-    
-    if (!IsValidPosition(to_row, to_col)) return 0;
-    if (GetPieceAt(game, to_row, to_col) != -1) return 0;
-    
-    int has_forced_capture = HasForcedCapture(game, player);
-    
-    if (has_forced_capture && !CanPieceCapture(game, from_row, from_col)) {     // Enforces capture rule
-        return 0;
-    }
-    
-    Move moves[12];
-    int move_count;
-    
-    GetPossibleMoves(game, from_row, from_col, moves, &move_count, has_forced_capture);     // Looks through legal moves
-    
-    for (int i = 0; i < move_count; i++) {      // If a legal move is what the user submits then valid
-        if (moves[i].to_row == to_row && moves[i].to_col == to_col) {
-            return 1;
-        }
+// Legal move cache
+// A turn asks about the same position several times (is the game over, must it capture, is the typed
+// move legal, play it, what can the bot pick from), and each of those used to generate the moves again.
+// The moves of the last position asked about are kept per thread, so the library stays reentrant, and
+// are matched on the whole position rather than its hash key. Search nodes don't go through here.
+typedef struct {
+    Bitboard pieces;
+    Bitboard kings;
+    int turn;                   // -1 while empty
+    int count;
+    Move moves[MAX_MOVES];
+} MoveCache;
+
+static _Thread_local MoveCache move_cache = {.turn = -1};
+
+const MoveCache *LegalMoves(GameState *game) {      // Side to move, good until this thread's next call
+    MoveCache *cache = &move_cache;
+    if (cache->turn != game->current_turn || cache->pieces != game->pieces || cache->kings != game->kings) {
+        cache->count = GenerateMoves(game, game->current_turn, cache->moves);
+        cache->pieces = game->pieces;
+        cache->kings = game->kings;
+        cache->turn = game->current_turn;
     }
-    
-    return 0;
+    return cache;
 }
 
-int CanContinueCapturing(GameState *game, int row, int col) {       // Checks for available captures after a capture
-    return CanPieceCapture(game, row, col);
+int SameMove(const Move *a, const Move *b) {      // Same piece along the same path
+    return a->from == b->from && a->hops == b->hops && memcmp(a->path, b->path, a->hops) == 0;
 }
 
-void MakeMove(GameState *game, int from_row, int from_col, int to_row, int to_col) {
-    int bit_pos_from = board_to_bitpos(from_row, from_col);     // Converts coords to bit
-    int bit_pos_to = board_to_bitpos(to_row, to_col);
+#define MOVE_CAPTURED CHECKERS_CAPTURED
+#define MOVE_KINGED   CHECKERS_KINGED
+
+typedef CheckersUndo MoveDelta;         // Everything a move changes. Made by adding it in, unmade by taking it back out
+
+void GetMoveDelta(GameState *game, const Move *move, MoveDelta *delta, const EvalWeights *eval) {
     int player = game->current_turn;
+    int from = move->from + 32 * player, to = move->to + 32 * player;
+    Bitboard moved = (1ULL << from) ^ (1ULL << to);     // Empty when a king's jumps end where it started
+    Bitboard taken = (Bitboard)move->captures << (32 * (1 - player));
+    Bitboard taken_kings = game->kings & taken;
+    int is_king = (game->kings >> from) & 1;
+    int kinged = !is_king && PromotesOn(player, move->to);
     
-    if (player == 0) {
-        ClearBit(&game->pieces, bit_pos_from);      // "Deletes" previous bit
-        SetBit(&game->pieces, bit_pos_to);          // Updates where it moves to
-        if (GetBit(game->kings, bit_pos_from)) {        // Dont forget to update the king board too
-            ClearBit(&game->kings, bit_pos_from);
-            SetBit(&game->kings, bit_pos_to);
-        }
-    } else {
-        ClearBit(&game->pieces, bit_pos_from + 32);
-        SetBit(&game->pieces, bit_pos_to + 32);
-        if (GetBit(game->kings, bit_pos_from + 32)) {
-            ClearBit(&game->kings, bit_pos_from + 32);
-            SetBit(&game->kings, bit_pos_to + 32);
+    delta->pieces = moved ^ taken;
+    delta->kings = (is_king ? moved : 0) ^ taken_kings ^ (kinged ? 1ULL << to : 0);
+    delta->key = zobrist_turn ^ zobrist_pieces[from] ^ zobrist_pieces[to];     // Cancels out when from == to
+    delta->eval = eval->piece[to] - eval->piece[from];
+    if (is_king) {
+        delta->key ^= zobrist_kings[from] ^ zobrist_kings[to];
+        delta->eval += eval->king[to] - eval->king[from];
+    } else if (kinged) {
+        delta->key ^= zobrist_kings[to];
+        delta->eval += eval->king[to];
+    }
+    for (Bitboard b = taken; b; b &= b - 1) {
+        int bit = __builtin_ctzll(b);
+        delta->key ^= zobrist_pieces[bit];
+        delta->eval -= eval->piece[bit];
+        if ((taken_kings >> bit) & 1) {
+            delta->key ^= zobrist_kings[bit];
+            delta->eval -= eval->king[bit];
         }
     }
     
-    int row_diff = to_row - from_row;
-    int col_diff = to_col - from_col;
-    
-    if (abs(row_diff) == 2 && abs(col_diff) == 2) {     // If the move is a capture, clear the additional squares
-        int jump_row = from_row + row_diff / 2;
-        int jump_col = from_col + col_diff / 2;
-        int jump_bit_pos = board_to_bitpos(jump_row, jump_col);
-        
-        ClearBit(&game->pieces, jump_bit_pos);
-        ClearBit(&game->pieces, jump_bit_pos + 32);
-        ClearBit(&game->kings, jump_bit_pos);
-        ClearBit(&game->kings, jump_bit_pos + 32);
-        printf("Captured %c%d\n", 'a' + jump_col, 8 - jump_row);
+    int kings_taken = CountBits(taken_kings);
+    delta->material[player][0] = -kinged;
+    delta->material[player][1] = kinged;
+    delta->material[1 - player][0] = -(CountBits(taken) - kings_taken);
+    delta->material[1 - player][1] = -kings_taken;
+    delta->reversible = taken || !is_king ? -game->reversible : 1;     // A capture or man move restarts the count
+    delta->flags = (taken ? MOVE_CAPTURED : 0) | (kinged ? MOVE_KINGED : 0);
+}
+
+static inline void MakeDelta(GameState *game, const MoveDelta *delta) {       // Plays the move and passes the turn
+    game->pieces ^= delta->pieces;
+    game->kings ^= delta->kings;
+    game->key ^= delta->key;
+    game->eval += delta->eval;
+    game->reversible += delta->reversible;
+    for (int i = 0; i < 4; i++) {
+        game->material[i / 2][i % 2] += delta->material[i / 2][i % 2];
     }
-    
-    if (!IsKing(game, to_row, to_col)) {        // When player's piece reaches the end switch it to king's board
-        if ((player == 0 && to_row == 0) || (player == 1 && to_row == 7)) {
-            if (player == 0) {
-                SetBit(&game->kings, bit_pos_to);
-            } else {
-                SetBit(&game->kings, bit_pos_to + 32);
-            }
-            printf("Kinged!\n");
+    game->current_turn ^= 1;
+}
+
+static inline void UnmakeDelta(GameState *game, const MoveDelta *delta) {     // Exactly undoes MakeDelta
+    game->pieces ^= delta->pieces;
+    game->kings ^= delta->kings;
+    game->key ^= delta->key;
+    game->eval -= delta->eval;
+    game->reversible -= delta->reversible;
+    for (int i = 0; i < 4; i++) {
+        game->material[i / 2][i % 2] -= delta->material[i / 2][i % 2];
+    }
+    game->current_turn ^= 1;
+}
+
+int ApplyMove(GameState *game, const Move *move) {      // Silent MakeMove, plays the whole turn and returns MOVE_* flags
+    MoveDelta delta;
+    GetMoveDelta(game, move, &delta, &default_weights);
+    MakeDelta(game, &delta);
+    return delta.flags;
+}
+
+void SquareName(int square, char *out) {        // Bit position to "c3"
+    int row, col;
+    bitpos_to_board(square, &row, &col);
+    out[0] = 'a' + col;
+    out[1] = '0' + 8 - row;
+    out[2] = '\0';
+}
+
+int FormatMove(const Move *move, char *out) {       // "c3-d4" or "e3xg5xe7", returns the length
+    int length = 2;
+    SquareName(move->from, out);
+    for (int i = 0; i < move->hops; i++) {
+        out[length] = move->captures ? 'x' : '-';
+        SquareName(move->path[i], out + length + 1);
+        length += 3;
+    }
+    return length;
+}
+
+void PrintMove(FILE *file, const Move *move) {
+    char text[CHECKERS_MOVE_TEXT];
+    FormatMove(move, text);
+    fputs(text, file);
+}
+
+int FindMove(GameState *game, const int squares[], int count, Move *move) {    // Matches typed squares to a legal move
+    const MoveCache *legal = LegalMoves(game);  // 2 for a whole move, 1 if the squares only start a jump sequence, else 0
+    const Move *moves = legal->moves;
+    int move_count = legal->count;
+    int found = 0;
+    for (int i = 0; i < move_count; i++) {
+        int hops = count - 1, same = count >= 2 && moves[i].from == squares[0] && moves[i].hops >= hops;
+        for (int h = 0; same && h < hops; h++) {
+            same = moves[i].path[h] == squares[h + 1];
         }
+        if (!same) continue;
+        if (moves[i].hops == hops) {
+            *move = moves[i];
+            return 2;
+        }
+        found = 1;
     }
+    return found;
 }
 
 int HasValidMoves(GameState *game, int player) {        // Is there no legal move or must capture, etc
-    for (int row = 0; row < 8; row++) {
-        for (int col = 0; col < 8; col++) {
-            if (GetPieceAt(game, row, col) == player) {
-                Move moves[12];
-                int move_count;
-                int must_capture = HasForcedCapture(game, player);
-                GetPossibleMoves(game, row, col, moves, &move_count, must_capture);
-                if (move_count > 0) {
-                    return 1;
-                }
-            }
-        }
+    return (GetJumpers(game, player) | GetMovers(game, player)) != 0;
+}
+
+// Game history
+// Captures and man moves can't be taken back, so a position can only come back within its reversible
+// plies, and every other one of those has the same side to move. A repetition check is at most
+// MOVE_RULE / 2 key compares whatever the game length, and none at all right after a capture or man move.
+// So the history only keeps the last MOVE_RULE + 1 keys, in a ring that pushes write over the oldest.
+#define MOVE_RULE   CHECKERS_MOVE_RULE
+
+typedef CheckersHistory History;
+
+static inline uint64_t HistoryKey(const History *history, int back) {      // back plies before the newest, back < count
+    return history->keys[(history->last - back + CHECKERS_HISTORY) % CHECKERS_HISTORY];
+}
+
+void HistoryPush(History *history, const GameState *game) {
+    history->last = (history->last + 1) % CHECKERS_HISTORY;
+    history->keys[history->last] = game->key;
+    if (history->count < CHECKERS_HISTORY) history->count++;
+}
+
+void HistoryPop(History *history) {     // What a push wrote over doesn't come back, the window is one shorter
+    if (history->count == 0) return;
+    history->last = (history->last + CHECKERS_HISTORY - 1) % CHECKERS_HISTORY;
+    history->count--;
+}
+
+void HistoryStart(History *history, const GameState *game) {
+    history->count = 0;
+    history->last = CHECKERS_HISTORY - 1;
+    HistoryPush(history, game);
+}
+
+int Repetitions(const History *history, const GameState *game) {      // Earlier times the last pushed position came up
+    int count = 0;
+    for (int back = 4; back < history->count && back <= game->reversible; back += 2) {
+        count += HistoryKey(history, back) == game->key;
     }
-    return 0;
+    return count;
 }
 
-int IsGameOver(GameState *game) {
-    return !HasValidMoves(game, 0) || !HasValidMoves(game, 1);
+int IsDrawn(const History *history, const GameState *game) {       // Move rule, or the third time a position comes up
+    return game->reversible >= MOVE_RULE || (history && Repetitions(history, game) >= 2);
 }
 
-// Bot stuff
-void MakeBotMove(GameState *game) {
-    int must_capture = HasForcedCapture(game, 1);       // The bot will always take when able to
-    Move all_moves[12 * 12];
-    int total_moves = 0;
-    
-    for (int row = 0; row < 8; row++) {     // Generates all possible moves 
-        for (int col = 0; col < 8; col++) {
-            if (GetPieceAt(game, row, col) == 1) {
-                Move piece_moves[12];
-                int piece_move_count;
-                GetPossibleMoves(game, row, col, piece_moves, &piece_move_count, must_capture);
-                
-                for (int i = 0; i < piece_move_count; i++) {
-                    all_moves[total_moves++] = piece_moves[i];
-                }
-            }
-        }
+// Transposition table
+// Buckets of four 16 byte entries fill a 64 byte cache line. The bucket count is a power of two so the
+// low bits of the key pick the bucket. Search threads share one table without a lock: each entry is
+// stored as (key ^ data, data), so a slot torn by two threads writing at once no longer matches its key
+// and is treated as a miss.
+#define BOUND_NONE  0
+#define BOUND_UPPER 1           // Score is at most this (failed low)
+#define BOUND_LOWER 2           // Score is at least this (failed high)
+#define BOUND_EXACT 3
+#define TT_BUCKET_SIZE 4
+
+typedef struct {                // Unpacked copy of one entry
+    int score;
+    int depth;
+    int bound;
+    int from, to;
+    int age;                    // Search that wrote it, stale entries get replaced first
+} TTEntry;
+
+typedef struct {
+    _Atomic uint64_t check;     // key ^ data
+    _Atomic uint64_t data;      // score:16 depth:8 bound:2 from:6 to:6 age:8
+} TTSlot;
+
+typedef struct {
+    TTSlot slots[TT_BUCKET_SIZE];
+} TTBucket;
+
+typedef struct {
+    TTBucket *buckets;
+    uint64_t mask;              // Bucket count - 1
+    uint8_t age;
+} TranspositionTable;
+
+static inline uint64_t TTPack(int score, int depth, int bound, int from, int to, int age) {
+    return (uint64_t)(uint16_t)score | (uint64_t)depth << 16 | (uint64_t)bound << 24 |
+           (uint64_t)from << 26 | (uint64_t)to << 32 | (uint64_t)age << 38;
+}
+
+static inline void TTUnpack(uint64_t data, TTEntry *entry) {
+    entry->score = (int16_t)(data & 0xFFFF);
+    entry->depth = (data >> 16) & 0xFF;
+    entry->bound = (data >> 24) & 3;
+    entry->from = (data >> 26) & 63;
+    entry->to = (data >> 32) & 63;
+    entry->age = (data >> 38) & 0xFF;
+}
+
+int TTInit(TranspositionTable *tt, size_t megabytes) {      // Rounds down to a power of two number of buckets
+    size_t count = 1;
+    while (count * 2 * sizeof(TTBucket) <= megabytes * 1024 * 1024) {
+        count *= 2;
     }
-    
-    if (total_moves == 0) {
-        printf("Bot has no moves\n");
-        return;
+    tt->buckets = calloc(count, sizeof(TTBucket));
+    if (!tt->buckets) {
+        tt->mask = 0;
+        return 0;
+    }
+    tt->mask = count - 1;
+    tt->age = 0;
+    return 1;
+}
+
+void TTFree(TranspositionTable *tt) {
+    free(tt->buckets);
+    tt->buckets = NULL;
+    tt->mask = 0;
+}
+
+void TTClear(TranspositionTable *tt) {
+    memset(tt->buckets, 0, (tt->mask + 1) * sizeof(TTBucket));
+    tt->age = 0;
+}
+
+int TTProbe(TranspositionTable *tt, uint64_t key, TTEntry *entry) {      // Returns 1 and fills entry on a hit
+    TTBucket *bucket = &tt->buckets[key & tt->mask];
+    for (int i = 0; i < TT_BUCKET_SIZE; i++) {
+        uint64_t data = atomic_load_explicit(&bucket->slots[i].data, memory_order_relaxed);
+        uint64_t check = atomic_load_explicit(&bucket->slots[i].check, memory_order_relaxed);
+        if ((check ^ data) == key && ((data >> 24) & 3) != BOUND_NONE) {
+            TTUnpack(data, entry);
+            return 1;
+        }
     }
+    return 0;
+}
+
+void TTStore(TranspositionTable *tt, uint64_t key, int depth, int bound, int score, int from, int to) {
+    TTBucket *bucket = &tt->buckets[key & tt->mask];
+    TTSlot *replace = NULL;
+    int replace_worth = 1 << 30;
+    TTEntry old;
     
-    if (must_capture) {     // Filter just capture moves and picks one at random if multiple exist
-        Move capture_moves[12 * 12];
-        int capture_count = 0;
-        
-        for (int i = 0; i < total_moves; i++) {
-            if (all_moves[i].capture_row != -1) {
-                capture_moves[capture_count++] = all_moves[i];
+    for (int i = 0; i < TT_BUCKET_SIZE; i++) {      // Same position, else the emptiest, oldest or shallowest slot
+        uint64_t data = atomic_load_explicit(&bucket->slots[i].data, memory_order_relaxed);
+        uint64_t check = atomic_load_explicit(&bucket->slots[i].check, memory_order_relaxed);
+        TTUnpack(data, &old);
+        if ((check ^ data) == key || old.bound == BOUND_NONE) {
+            replace = &bucket->slots[i];
+            if (old.bound != BOUND_NONE && from == NO_SQUARE) {     // Keep the old best move if there is no new one
+                from = old.from;
+                to = old.to;
             }
+            break;
         }
-        
-        if (capture_count > 0) {
-            int random_index = rand() % capture_count;
-            Move selected_move = capture_moves[random_index];
-            
-            printf("Bot: %c%d %c%d\n", 
-                   'a' + selected_move.from_col, 8 - selected_move.from_row,
-                   'a' + selected_move.to_col, 8 - selected_move.to_row);
-            
-            MakeMove(game, selected_move.from_row, selected_move.from_col,
-                     selected_move.to_row, selected_move.to_col);
-            
-            if (CanContinueCapturing(game, selected_move.to_row, selected_move.to_col)) {       // Resrusion if another capture
-                printf("Bot continues capturing...\n");
-                game->current_turn = 1;
-                MakeBotMove(game);
-            }
-            return;
+        int worth = old.depth - (old.age != tt->age ? 64 : 0);
+        if (worth < replace_worth) {
+            replace = &bucket->slots[i];
+            replace_worth = worth;
         }
     }
     
-    int random_index = rand() % total_moves;        // Random bot move
-    Move selected_move = all_moves[random_index];
-    
-    printf("Bot: %c%d %c%d\n", 
-           'a' + selected_move.from_col, 8 - selected_move.from_row,
-           'a' + selected_move.to_col, 8 - selected_move.to_row);
-    
-    MakeMove(game, selected_move.from_row, selected_move.from_col, 
-             selected_move.to_row, selected_move.to_col);
+    uint64_t data = TTPack(score, depth, bound, from, to, tt->age);
+    atomic_store_explicit(&replace->data, data, memory_order_relaxed);
+    atomic_store_explicit(&replace->check, key ^ data, memory_order_relaxed);
 }
 
+// Endgame tablebase
+// Win/loss/draw for every position with up to max_pieces pieces and red to move. Black to move is
+// looked up by turning the board around: square s becomes 31 - s and the colors swap sides.
+// A slice holds one material split (red men, red kings, black men, black kings). Its index places
+// each group in turn on the squares the earlier groups left free, using the colex combination rank.
+// On disk every slice is run length coded in blocks of TB_BLOCK positions behind an offset table,
+// so a probe decodes at most one block straight out of the mapped file.
+//
+// File: magic, max_pieces, slice offsets[(max_pieces + 1)^4]
+// Slice: position count, block offsets[blocks + 1] (from the end of the table), block bytes
+// Block byte: (run length - 1) << 2 | value, runs of 1-64
+#define TB_DRAW     0
+#define TB_WIN      1
+#define TB_LOSS     2
+#define TB_INVALID  3           // Generator only, men sitting on their own promotion row
+#define TB_BLOCK    4096
+#define TB_MAX_PIECES 8
+#define TB_MAGIC    0x31425443U         // "CTB1"
 
-// File I/O
-int SaveGame(GameState *game, const char *filename);
-int LoadGame(GameState *game, const char *filename);
+typedef struct {
+    const uint8_t *data;        // The mapped file
+    size_t size;
+    int max_pieces;
+} Tablebase;
 
-int SaveGame(GameState *game, const char *filename) {
-    FILE *file = fopen(filename, "w");
-    if (!file) {
-        printf("Error: Could not open file '%s' for writing\n", filename);
-        return 0;
+uint64_t tb_choose[33][TB_MAX_PIECES + 1];      // Pascal's triangle, filled by TBInitChoose
+
+void TBInitChoose() {
+    for (int n = 0; n <= 32; n++) {
+        tb_choose[n][0] = 1;
+        for (int k = 1; k <= TB_MAX_PIECES; k++) {
+            tb_choose[n][k] = n == 0 ? 0 : tb_choose[n - 1][k - 1] + tb_choose[n - 1][k];
+        }
     }
-    
-    fprintf(file, "%llu\n", game->pieces); // Logs all three of the game state values
-    fprintf(file, "%llu\n", game->kings);
-    fprintf(file, "%d\n", game->current_turn);
-    
-    fclose(file);
-    printf("Game saved to '%s'\n", filename);
-    return 1;
 }
 
-int LoadGame(GameState *game, const char *filename) {
-    FILE *file = fopen(filename, "r");
-    if (!file) {
-        printf("Error: Could not open file '%s' for reading\n", filename);
-        return 0;
+static inline uint64_t TBChoose(int n, int k) {
+    return (n < 0 || k > n) ? 0 : tb_choose[n][k];
+}
+
+static uint32_t Reverse32(uint32_t x) {         // Turns the board around
+    x = ((x >> 1) & 0x55555555U) | ((x & 0x55555555U) << 1);
+    x = ((x >> 2) & 0x33333333U) | ((x & 0x33333333U) << 2);
+    x = ((x >> 4) & 0x0F0F0F0FU) | ((x & 0x0F0F0F0FU) << 4);
+    x = ((x >> 8) & 0x00FF00FFU) | ((x & 0x00FF00FFU) << 8);
+    return (x >> 16) | (x << 16);
+}
+
+typedef struct {                // A position seen from the side to move, which plays red's direction
+    uint32_t men[2], kings[2];  // [0] side to move, [1] opponent
+} TBPosition;
+
+static void TBCanonical(GameState *game, TBPosition *pos) {
+    uint32_t own = SideBits(game->pieces, game->current_turn), opp = SideBits(game->pieces, 1 - game->current_turn);
+    uint32_t own_kings = own & SideBits(game->kings, game->current_turn);
+    uint32_t opp_kings = opp & SideBits(game->kings, 1 - game->current_turn);
+    if (game->current_turn == 1) {
+        own = Reverse32(own);
+        opp = Reverse32(opp);
+        own_kings = Reverse32(own_kings);
+        opp_kings = Reverse32(opp_kings);
     }
-    
-    if (fscanf(file, "%llu", &game->pieces) != 1) {
-        printf("Error: Invalid file format in '%s'\n", filename);
-        fclose(file);
-        return 0;
+    pos->men[0] = own & ~own_kings;
+    pos->men[1] = opp & ~opp_kings;
+    pos->kings[0] = own_kings;
+    pos->kings[1] = opp_kings;
+}
+
+static int TBSliceKey(int max_pieces, int rm, int rk, int bm, int bk) {
+    int d = max_pieces + 1;
+    return ((rm * d + rk) * d + bm) * d + bk;
+}
+
+static uint64_t TBSliceSize(int rm, int rk, int bm, int bk) {
+    return TBChoose(32, rm) * TBChoose(32 - rm, bm) * TBChoose(32 - rm - bm, rk) * TBChoose(32 - rm - bm - rk, bk);
+}
+
+static uint64_t TBRankGroup(uint32_t group, uint32_t *free_squares) {     // Colex rank among the free squares
+    uint64_t index = 0;
+    int k = 1;
+    for (uint32_t b = group; b; b &= b - 1, k++) {
+        int square = __builtin_ctz(b);
+        index += TBChoose(CountBits(*free_squares & ((1U << square) - 1)), k);
     }
-    
-    if (fscanf(file, "%llu", &game->kings) != 1) {
-        printf("Error: Invalid file format in '%s'\n", filename);
-        fclose(file);
+    *free_squares &= ~group;
+    return index;
+}
+
+static uint64_t TBIndex(TBPosition *pos) {
+    uint32_t free_squares = 0xFFFFFFFFU;
+    int bm = CountBits(pos->men[1]), rk = CountBits(pos->kings[0]), bk = CountBits(pos->kings[1]);
+    uint64_t index = TBRankGroup(pos->men[0], &free_squares);
+    index = index * TBChoose(CountBits(free_squares), bm) + TBRankGroup(pos->men[1], &free_squares);
+    index = index * TBChoose(CountBits(free_squares), rk) + TBRankGroup(pos->kings[0], &free_squares);
+    index = index * TBChoose(CountBits(free_squares), bk) + TBRankGroup(pos->kings[1], &free_squares);
+    return index;
+}
+
+static int TBBlockValue(const uint8_t *block, int offset) {     // Walks the runs up to offset
+    for (;;) {
+        int run = (*block >> 2) + 1;
+        if (offset < run) return *block & 3;
+        offset -= run;
+        block++;
+    }
+}
+
+int TBOpen(Tablebase *tb, const char *filename) {       // Maps the file, nothing is read up front. 0 if it's missing or invalid
+    int fd = open(filename, O_RDONLY);
+    if (fd < 0) return 0;
+    struct stat st;
+    if (fstat(fd, &st) != 0 || st.st_size < 8) {
+        close(fd);
         return 0;
     }
+    void *map = mmap(NULL, st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (map == MAP_FAILED) return 0;
     
-    if (fscanf(file, "%d", &game->current_turn) != 1) {
-        printf("Error: Invalid file format in '%s'\n", filename);
-        fclose(file);
+    const uint32_t *header = map;
+    if (header[0] != TB_MAGIC || header[1] > TB_MAX_PIECES) {
+        munmap(map, st.st_size);
         return 0;
     }
-    
-    fclose(file);
-    printf("Game loaded from '%s'\n", filename);
+    tb->data = map;
+    tb->size = st.st_size;
+    tb->max_pieces = header[1];
     return 1;
 }
 
-// Game stuff
-int input_to_coords(char *input, int *from_row, int *from_col, int *to_row, int *to_col) {
-    if (strlen(input) < 5) return 0;        //converts algebraic to the board coords
+void TBClose(Tablebase *tb) {
+    munmap((void *)tb->data, tb->size);
+    tb->data = NULL;
+}
+
+int TBProbe(Tablebase *tb, GameState *game) {      // TB_WIN/TB_LOSS/TB_DRAW for the side to move, -1 if not covered
+    TBPosition pos;
+    TBCanonical(game, &pos);
+    int rm = CountBits(pos.men[0]), rk = CountBits(pos.kings[0]);
+    int bm = CountBits(pos.men[1]), bk = CountBits(pos.kings[1]);
+    if (rm + rk == 0) return TB_LOSS;
+    if (bm + bk == 0) return TB_WIN;
+    if (rm + rk + bm + bk > tb->max_pieces) return -1;
     
-    *from_col = tolower(input[0]) - 'a';
-    *from_row = 8 - (input[1] - '0');
-    *to_col = tolower(input[3]) - 'a';
-    *to_row = 8 - (input[4] - '0');
+    const uint64_t *offsets = (const uint64_t *)(tb->data + 8);
+    uint64_t slice_offset = offsets[TBSliceKey(tb->max_pieces, rm, rk, bm, bk)];
+    if (slice_offset == 0) return -1;
     
-    return 1;
+    const uint64_t *slice = (const uint64_t *)(tb->data + slice_offset);
+    uint64_t index = TBIndex(&pos);
+    uint64_t blocks = (slice[0] + TB_BLOCK - 1) / TB_BLOCK;
+    const uint8_t *block_data = (const uint8_t *)(slice + 1 + blocks + 1);
+    return TBBlockValue(block_data + slice[1 + index / TB_BLOCK], index % TB_BLOCK);
 }
 
-int main() {
-    srand(time(NULL));
-    GameState game;
-    InitializeGame(&game);
-    
-    printf("-------------------------------- Single Player Checkers --------------------------------\n");
-    printf("Input options: 'xy xy' (c3 d4), 'binary', 'hex', 'save {name}', 'load {name}', 'quit'\n");
-    printf("-------------------------------- ---------------------- --------------------------------\n");
+// Generator: slices are solved in order of piece count and then men count, because a capture
+// only leads to fewer pieces and a promotion to fewer men. A slice and its color mirror feed each
+// other through quiet moves, so the pair is solved together by retrograde analysis:
+//   1. Every position looks at its captures and promotions, which land in solved slices, and counts
+//      its quiet moves that stay in the pair.
+//   2. Newly lost positions make every position that can move into them a win. Newly won positions
+//      take one off the count of every position that can move into them, and a count reaching zero
+//      means every move loses. Predecessors come from unmoving the opponent's pieces.
+// Whatever is still unresolved after that can't be forced either way and is a draw.
+#define TB_NEW      4           // Value flag: resolved since the last propagation sweep
+#define TB_NEVER    255         // Count for positions with a drawing way out, they can't lose
+
+typedef struct {
+    int max_pieces;
+    uint8_t **values;           // Per slice key, one byte per index while generating
+    uint8_t **counts;           // Per slice key, quiet moves not yet known to lose (pair being solved only)
+} TBGenerator;
+
+static uint32_t TBUnrankGroup(uint64_t index, int k, uint32_t *free_squares) {
+    uint32_t group = 0;
+    int c = CountBits(*free_squares) - 1;
+    for (; k >= 1; k--) {
+        while (TBChoose(c, k) > index) c--;
+        index -= TBChoose(c, k);
+        uint32_t b = *free_squares;         // c-th free square
+        for (int i = 0; i < c; i++) b &= b - 1;
+        group |= b & -b;
+        c--;
+    }
+    *free_squares &= ~group;
+    return group;
+}
+
+static void TBUnindex(uint64_t index, int rm, int rk, int bm, int bk, TBPosition *pos) {
+    uint64_t sizes[4];
+    sizes[0] = TBChoose(32, rm);
+    sizes[1] = TBChoose(32 - rm, bm);
+    sizes[2] = TBChoose(32 - rm - bm, rk);
+    sizes[3] = TBChoose(32 - rm - bm - rk, bk);
+    uint64_t parts[4];
+    for (int i = 3; i >= 0; i--) {
+        parts[i] = index % sizes[i];
+        index /= sizes[i];
+    }
+    uint32_t free_squares = 0xFFFFFFFFU;
+    pos->men[0] = TBUnrankGroup(parts[0], rm, &free_squares);
+    pos->men[1] = TBUnrankGroup(parts[1], bm, &free_squares);
+    pos->kings[0] = TBUnrankGroup(parts[2], rk, &free_squares);
+    pos->kings[1] = TBUnrankGroup(parts[3], bk, &free_squares);
+}
+
+static void TBToGame(TBPosition *pos, int turn, GameState *game) {     // Canonical sides back onto a board
+    game->pieces = (pos->men[0] | pos->kings[0]) | (Bitboard)(pos->men[1] | pos->kings[1]) << 32;
+    game->kings = pos->kings[0] | (Bitboard)pos->kings[1] << 32;
+    game->current_turn = turn;
+    game->key = 0;              // Not needed here, the generator indexes positions directly
+    game->eval = 0;
+    game->reversible = 0;
+    memset(game->material, 0, sizeof(game->material));
+}
+
+static int TBTurnResults(GameState *game, GameState results[]) {   // Every position a move can reach
+    Move moves[MAX_MOVES];
+    int count = GenerateMoves(game, game->current_turn, moves);
+    for (int i = 0; i < count; i++) {
+        results[i] = *game;
+        ApplyMove(&results[i], &moves[i]);
+    }
+    return count;
+}
 
-    int chain_jump = 0;
-    int chain_row = -1, chain_col = -1;
+static uint8_t *TBLocate(TBGenerator *gen, GameState *game, uint8_t **count) {     // Value byte of a position, NULL when a side is empty
+    TBPosition pos;
+    TBCanonical(game, &pos);
+    int rm = CountBits(pos.men[0]), rk = CountBits(pos.kings[0]);
+    int bm = CountBits(pos.men[1]), bk = CountBits(pos.kings[1]);
+    if (rm + rk == 0 || bm + bk == 0) return NULL;
+    int key = TBSliceKey(gen->max_pieces, rm, rk, bm, bk);
+    uint64_t index = TBIndex(&pos);
+    if (count) *count = gen->counts[key] ? &gen->counts[key][index] : NULL;
+    return &gen->values[key][index];
+}
+
+static uint64_t TBInitialPass(TBGenerator *gen, int rm, int rk, int bm, int bk) {     // Step 1, returns positions resolved
+    int key = TBSliceKey(gen->max_pieces, rm, rk, bm, bk);
+    uint8_t *values = gen->values[key], *counts = gen->counts[key];
+    uint64_t size = TBSliceSize(rm, rk, bm, bk);
+    uint64_t resolved = 0;
+    GameState results[MAX_MOVES];
     
-    while (!IsGameOver(&game)) {
-        PrintBoard(&game);
+    for (uint64_t index = 0; index < size; index++) {
+        if (values[index] == TB_INVALID) continue;
+        TBPosition pos;
+        TBUnindex(index, rm, rk, bm, bk, &pos);
+        GameState game;
+        TBToGame(&pos, 0, &game);
         
-        if (game.current_turn == 0) {   // Alternate 0,1 (player,bot)
-            if (HasForcedCapture(&game, game.current_turn)) {   // "Mandatory" capture clause
-                printf("You must capture\n");
+        int count = TBTurnResults(&game, results);
+        int value = TB_DRAW, quiet = 0, way_out = 0;
+        for (int i = 0; i < count; i++) {
+            int same_slice = CountBits(results[i].pieces) == CountBits(game.pieces) &&
+                             CountBits(results[i].kings) == CountBits(game.kings);
+            if (same_slice) {                       // Quiet move, its value comes later
+                quiet++;
+                continue;
             }
-            
-            char input[20];         // User input
-            if (chain_jump) {       // Prompts chaining messages
-                printf("\nChain jump on %c%d ", 
-                       'a' + chain_col, 8 - chain_row);
-            } else {
-                printf("\nYour move (r): ");
+            uint8_t *reply = TBLocate(gen, &results[i], NULL);
+            int reply_value = reply ? (*reply & 3) : TB_LOSS;       // Taking the last piece wins
+            if (reply_value == TB_LOSS) {
+                value = TB_WIN;
+                break;
+            } else if (reply_value == TB_DRAW) {
+                way_out = 1;
             }
-            
-            if (fgets(input, sizeof(input), stdin) == NULL) break;
-            
-            input[strcspn(input, "\n")] = 0;    
+        }
+        if (value != TB_WIN && !way_out && quiet == 0) {
+            value = TB_LOSS;                        // No moves at all, or every one loses
+        }
+        if (value != TB_DRAW) {
+            values[index] = value | TB_NEW;
+            resolved++;
+        }
+        counts[index] = way_out ? TB_NEVER : quiet;
+    }
+    return resolved;
+}
 
-            if (strcmp(input, "binary") == 0) {     // Display commands
-                PrintBinary(game.pieces);
-                continue;
-            } else if (strcmp(input, "hex") == 0) {
-                PrintHex(game.pieces);
-                continue;
-            } else if (strcmp(input, "quit") == 0) {
-                break;
-            } else if (strncmp(input, "save ", 5) == 0) {
-                SaveGame(&game, input + 5);
-                continue;
-            } else if (strncmp(input, "load ", 5) == 0) {       // Resets variables upon load
-                if (LoadGame(&game, input + 5)) {
-                    chain_jump = 0;
-                    chain_row = -1;
-                    chain_col = -1;
+static uint64_t TBPropagatePass(TBGenerator *gen, int rm, int rk, int bm, int bk) {     // Step 2, one sweep
+    uint8_t *values = gen->values[TBSliceKey(gen->max_pieces, rm, rk, bm, bk)];
+    uint64_t size = TBSliceSize(rm, rk, bm, bk);
+    uint64_t resolved = 0;
+    
+    for (uint64_t index = 0; index < size; index++) {
+        if (!(values[index] & TB_NEW)) continue;
+        values[index] &= 3;
+        TBPosition pos;
+        TBUnindex(index, rm, rk, bm, bk, &pos);
+        
+        // The opponent moved last, in black's direction. Men come back up, kings from anywhere.
+        // A king may not have been a man a move ago, that would be a promotion from another slice.
+        uint32_t empty = ~(pos.men[0] | pos.kings[0] | pos.men[1] | pos.kings[1]);
+        for (int dir = 0; dir < 4; dir++) {
+            uint32_t movers = pos.kings[1] | (dir == UP_LEFT || dir == UP_RIGHT ? pos.men[1] : 0);
+            for (uint32_t b = movers; b; b &= b - 1) {
+                uint32_t to_bit = b & -b;
+                uint32_t from_bit = Step(to_bit, dir) & empty;
+                if (!from_bit) continue;
+                
+                TBPosition before = pos;
+                if (pos.kings[1] & to_bit) {
+                    before.kings[1] ^= to_bit | from_bit;
+                } else {
+                    before.men[1] ^= to_bit | from_bit;
                 }
-                continue;
+                GameState game;
+                TBToGame(&before, 1, &game);
+                if (GetJumpers(&game, 1)) continue;     // Had a capture, so it couldn't have made this move
+                
+                uint8_t *count;
+                uint8_t *value = TBLocate(gen, &game, &count);
+                if (*value != TB_DRAW) continue;        // Already resolved
+                if (values[index] == TB_LOSS) {
+                    *value = TB_WIN | TB_NEW;
+                    resolved++;
+                } else if (*count != TB_NEVER && --*count == 0) {
+                    *value = TB_LOSS | TB_NEW;
+                    resolved++;
+                }
+            }
+        }
+    }
+    return resolved;
+}
+
+static int TBAllocSlice(TBGenerator *gen, int rm, int rk, int bm, int bk) {
+    int key = TBSliceKey(gen->max_pieces, rm, rk, bm, bk);
+    if (gen->values[key]) return 1;
+    uint64_t size = TBSliceSize(rm, rk, bm, bk);
+    uint8_t *values = malloc(size);
+    gen->counts[key] = malloc(size);
+    if (!values || !gen->counts[key]) return 0;
+    for (uint64_t index = 0; index < size; index++) {       // Men can't stand on the row where they'd be kinged
+        TBPosition pos;
+        TBUnindex(index, rm, rk, bm, bk, &pos);
+        values[index] = ((pos.men[0] & 0x0000000FU) || (pos.men[1] & 0xF0000000U)) ? TB_INVALID : TB_DRAW;
+    }
+    gen->values[key] = values;
+    return 1;
+}
+
+static size_t TBEncodeSlice(uint8_t *values, uint64_t size, uint8_t *out, uint64_t *block_offsets) {    // Returns bytes written
+    size_t length = 0;
+    uint64_t blocks = (size + TB_BLOCK - 1) / TB_BLOCK;
+    for (uint64_t block = 0; block < blocks; block++) {
+        block_offsets[block] = length;
+        uint64_t end = (block + 1) * TB_BLOCK < size ? (block + 1) * TB_BLOCK : size;
+        uint64_t index = block * TB_BLOCK;
+        while (index < end) {
+            int value = values[index] == TB_INVALID ? (index > block * TB_BLOCK ? values[index - 1] : TB_DRAW) : values[index];
+            values[index] = value;          // Invalid positions join whatever run they sit in
+            int run = 1;
+            while (index + run < end && run < 64 &&
+                   (values[index + run] == value || values[index + run] == TB_INVALID)) {
+                values[index + run] = value;
+                run++;
             }
-            
-            int from_row, from_col, to_row, to_col;
-            if (chain_jump) {
-                from_row = chain_row;
-                from_col = chain_col;
-                if (!input_to_coords(input, &from_row, &from_col, &to_row, &to_col)) {
-                    printf("Invalid format! Use algebraic (a3 b4)\n");
-                    continue;
+            out[length++] = (run - 1) << 2 | value;
+            index += run;
+        }
+    }
+    block_offsets[blocks] = length;
+    return length;
+}
+
+int CheckersTBGenerate(int max_pieces, const char *filename) {
+    if (max_pieces < 2 || max_pieces > TB_MAX_PIECES) {
+        printf("Error: Tablebases cover 2 to %d pieces\n", TB_MAX_PIECES);
+        return 0;
+    }
+    int d = max_pieces + 1;
+    TBGenerator gen;
+    gen.max_pieces = max_pieces;
+    gen.values = calloc(d * d * d * d, sizeof(uint8_t *));
+    gen.counts = calloc(d * d * d * d, sizeof(uint8_t *));
+    if (!gen.values || !gen.counts) return 0;
+    double start = NowSeconds();
+    
+    for (int total = 2; total <= max_pieces; total++) {
+        for (int men = 0; men <= total; men++) {
+            for (int rm = 0; rm <= men; rm++) {
+                int bm = men - rm;
+                for (int rk = 0; rk <= total - men; rk++) {
+                    int bk = total - men - rk;
+                    if (rm + rk == 0 || bm + bk == 0) continue;
+                    if (rm > bm || (rm == bm && rk > bk)) continue;       // The mirror is solved with its partner
+                    if (!TBAllocSlice(&gen, rm, rk, bm, bk) || !TBAllocSlice(&gen, bm, bk, rm, rk)) {
+                        printf("Error: Out of memory for slice %d%d%d%d\n", rm, rk, bm, bk);
+                        return 0;
+                    }
+                    
+                    int mirrored = rm != bm || rk != bk;
+                    uint64_t resolved = TBInitialPass(&gen, rm, rk, bm, bk);
+                    if (mirrored) resolved += TBInitialPass(&gen, bm, bk, rm, rk);
+                    int passes = 0;
+                    while (resolved > 0) {
+                        resolved = TBPropagatePass(&gen, rm, rk, bm, bk);
+                        if (mirrored) resolved += TBPropagatePass(&gen, bm, bk, rm, rk);
+                        passes++;
+                    }
+                    
+                    int keys[2] = {TBSliceKey(max_pieces, rm, rk, bm, bk), TBSliceKey(max_pieces, bm, bk, rm, rk)};
+                    for (int i = 0; i < 2; i++) {       // Counts are only needed while the pair is open
+                        free(gen.counts[keys[i]]);
+                        gen.counts[keys[i]] = NULL;
+                    }
+                    printf("Solved %d men %d kings vs %d men %d kings in %d passes\n", rm, rk, bm, bk, passes);
                 }
-                from_row = chain_row;
-                from_col = chain_col;
-            } else {
-                if (!input_to_coords(input, &from_row, &from_col, &to_row, &to_col)) {
-                    printf("Invalid format! Use algebraic (a3 b4)\n");
-                    continue;
+            }
+        }
+    }
+    
+    FILE *file = fopen(filename, "wb");
+    if (!file) {
+        printf("Error: Could not open file '%s' for writing\n", filename);
+        return 0;
+    }
+    uint32_t header[2] = {TB_MAGIC, max_pieces};
+    uint64_t *slice_offsets = calloc(d * d * d * d, sizeof(uint64_t));
+    fwrite(header, sizeof(header), 1, file);
+    fwrite(slice_offsets, sizeof(uint64_t), d * d * d * d, file);       // Filled in once the offsets are known
+    
+    uint64_t offset = 8 + sizeof(uint64_t) * d * d * d * d, positions = 0;
+    for (int key = 0; key < d * d * d * d; key++) {
+        if (!gen.values[key]) continue;
+        int rm = key / (d * d * d), rk = key / (d * d) % d, bm = key / d % d, bk = key % d;
+        uint64_t size = TBSliceSize(rm, rk, bm, bk);
+        uint64_t blocks = (size + TB_BLOCK - 1) / TB_BLOCK;
+        uint64_t *block_offsets = malloc((blocks + 1) * sizeof(uint64_t));
+        uint8_t *data = malloc(size);       // Worst case is one byte per position
+        size_t length = TBEncodeSlice(gen.values[key], size, data, block_offsets);
+        
+        slice_offsets[key] = offset;
+        fwrite(&size, sizeof(size), 1, file);
+        fwrite(block_offsets, sizeof(uint64_t), blocks + 1, file);
+        fwrite(data, 1, length, file);
+        offset += sizeof(uint64_t) * (blocks + 2) + length;
+        positions += size;
+        
+        free(block_offsets);
+        free(data);
+        free(gen.values[key]);
+    }
+    fseek(file, 8, SEEK_SET);
+    fwrite(slice_offsets, sizeof(uint64_t), d * d * d * d, file);
+    fclose(file);
+    
+    printf("Wrote %llu positions in %llu bytes to '%s' (%.1f s)\n", (unsigned long long)positions,
+           (unsigned long long)offset, filename, NowSeconds() - start);
+    free(slice_offsets);
+    free(gen.values);
+    free(gen.counts);
+    return 1;
+}
+
+// Evaluation
+// A weighted sum of features, each one counted for red minus black straight from masks of the boards:
+//   men, kings, advance    material and rows moved up, kept in GameState.eval by the moves
+//   back rank              men still guarding their own back row against kings
+//   centre                 pieces on the eight middle squares
+//   mobility               quiet steps the pieces could take
+//   runaway                men with an empty path to the far row, three steps away at most
+// Evaluate adds the last four to GameState.eval. EvaluateBatch works out the whole sum for many
+// positions at once, one position per 32 bit lane, with AVX-512 or AVX2 when the CPU has them.
+#define CENTRE_SQUARES  0x00666600U     // Rows 3-6, columns c-f
+#define ADVANCE_BIT0    0xF0F0F0F0U     // Rows whose number has bit 0 set, for adding up rows as bits
+#define ADVANCE_BIT1    0xFF00FF00U
+#define ADVANCE_BIT2    0xFFFF0000U
+#define EVAL_LANES      16
+
+static void SideFeatures(uint32_t own, uint32_t kings, uint32_t empty, int player, int features[], int first) {
+    uint32_t men = own & ~kings;             // Fills features[first..] for one side
+    int back = player == 0 ? DOWN_LEFT : UP_LEFT;       // Toward the side's own back row
+    
+    if (first <= EVAL_ADVANCE) {
+        uint32_t flip = player == 0 ? ~0U : 0;          // Red counts rows from the bottom
+        features[EVAL_MEN] = CountBits(men);
+        features[EVAL_KINGS] = CountBits(kings);
+        features[EVAL_ADVANCE] = CountBits(men & (ADVANCE_BIT0 ^ flip)) + 2 * CountBits(men & (ADVANCE_BIT1 ^ flip)) +
+                                 4 * CountBits(men & (ADVANCE_BIT2 ^ flip));
+    }
+    features[EVAL_BACK_RANK] = CountBits(men & promotion_rows[1 - player]);
+    features[EVAL_CENTRE] = CountBits(own & CENTRE_SQUARES);
+    
+    int mobility = 0;
+    for (int dir = 0; dir < 4; dir++) {
+        int forward = (player == 0) == (dir == UP_LEFT || dir == UP_RIGHT);
+        mobility += CountBits(Step(forward ? own : kings, dir) & empty);
+    }
+    features[EVAL_MOBILITY] = mobility;
+    
+    uint32_t path = promotion_rows[player] & empty, reach = 0;
+    for (int i = 0; i < 3; i++) {           // Walk back from the empty far row squares
+        path = Step(path, back) | Step(path, back + 1);
+        reach |= path;
+        path &= empty;
+    }
+    features[EVAL_RUNAWAY] = CountBits(men & reach);
+}
+
+static void EvalFeatures(GameState *game, int features[], int first) {     // Red minus black, from features[first] on
+    uint32_t red = SideBits(game->pieces, 0), black = SideBits(game->pieces, 1);
+    uint32_t empty = ~(red | black);
+    int black_features[EVAL_FEATURES];
+    SideFeatures(red, red & SideBits(game->kings, 0), empty, 0, features, first);
+    SideFeatures(black, black & SideBits(game->kings, 1), empty, 1, black_features, first);
+    for (int i = first; i < EVAL_FEATURES; i++) {
+        features[i] -= black_features[i];
+    }
+}
+
+int Evaluate(GameState *game, const EvalWeights *eval) {        // From the side to move, game->eval made with the same weights
+    int features[EVAL_FEATURES];
+    EvalFeatures(game, features, EVAL_BACK_RANK);
+    int score = game->eval;             // Material and advancement are kept up to date by the moves
+    for (int i = EVAL_BACK_RANK; i < EVAL_FEATURES; i++) {
+        score += eval->weights[i] * features[i];
+    }
+    return game->current_turn == 0 ? score : -score;
+}
+
+static int EvaluateFull(GameState *game, const int weights[EVAL_FEATURES]) {       // Same as Evaluate without trusting GameState.eval
+    int features[EVAL_FEATURES], score = 0;
+    EvalFeatures(game, features, 0);
+    for (int i = 0; i < EVAL_FEATURES; i++) {
+        score += weights[i] * features[i];
+    }
+    return game->current_turn == 0 ? score : -score;
+}
+
+// The lanes hold the four board halves (red, black, red kings, black kings) of EVAL_LANES positions.
+// The body is plain GCC vector code, built once per instruction set and picked when the program starts.
+// Vectors only go through macros and pointers, passing them by value would depend on the instruction set.
+typedef uint32_t EvalVector __attribute__((vector_size(EVAL_LANES * 4)));
+typedef void (*EvalKernel)(const uint32_t halves[4][EVAL_LANES], const int weights[EVAL_FEATURES], int scores[]);
+
+#define VECTOR_STEP(b, dir) ((dir) == UP_LEFT ? ((b) & EVEN_ROWS) >> 4 | ((b) & (ODD_ROWS & ~LEFT_SLOT)) >> 5 : \
+                             (dir) == UP_RIGHT ? ((b) & (EVEN_ROWS & ~RIGHT_SLOT)) >> 3 | ((b) & ODD_ROWS) >> 4 : \
+                             (dir) == DOWN_LEFT ? ((b) & EVEN_ROWS) << 4 | ((b) & (ODD_ROWS & ~LEFT_SLOT)) << 3 : \
+                             ((b) & (EVEN_ROWS & ~RIGHT_SLOT)) << 5 | ((b) & ODD_ROWS) << 4)
+
+#define VECTOR_COUNT(v) ({ EvalVector x_ = (v);         /* Popcount of every lane */ \
+                           x_ = x_ - ((x_ >> 1) & 0x55555555U); \
+                           x_ = (x_ & 0x33333333U) + ((x_ >> 2) & 0x33333333U); \
+                           x_ = (x_ + (x_ >> 4)) & 0x0F0F0F0FU; \
+                           (x_ * 0x01010101U) >> 24; })
+
+static inline __attribute__((always_inline)) void VectorSide(const EvalVector *pieces, const EvalVector *king_bits,
+                                                             const EvalVector *empty_bits, int player, const int weights[],
+                                                             EvalVector *score) {
+    EvalVector own = *pieces, kings = *king_bits & own, empty = *empty_bits;
+    EvalVector men = own & ~kings;          // Weighted features of one side, same as SideFeatures
+    uint32_t flip = player == 0 ? ~0U : 0;
+    int back = player == 0 ? DOWN_LEFT : UP_LEFT, forward = player == 0 ? UP_LEFT : DOWN_LEFT;
+    
+    *score = VECTOR_COUNT(men) * (uint32_t)weights[EVAL_MEN] + VECTOR_COUNT(kings) * (uint32_t)weights[EVAL_KINGS];
+    EvalVector advance = VECTOR_COUNT(men & (ADVANCE_BIT0 ^ flip)) + (VECTOR_COUNT(men & (ADVANCE_BIT1 ^ flip)) << 1) +
+                         (VECTOR_COUNT(men & (ADVANCE_BIT2 ^ flip)) << 2);
+    *score += advance * (uint32_t)weights[EVAL_ADVANCE];
+    *score += VECTOR_COUNT(men & promotion_rows[1 - player]) * (uint32_t)weights[EVAL_BACK_RANK];
+    *score += VECTOR_COUNT(own & CENTRE_SQUARES) * (uint32_t)weights[EVAL_CENTRE];
+    
+    EvalVector mobility = VECTOR_COUNT(VECTOR_STEP(own, forward) & empty) + VECTOR_COUNT(VECTOR_STEP(own, forward + 1) & empty) +
+                          VECTOR_COUNT(VECTOR_STEP(kings, back) & empty) + VECTOR_COUNT(VECTOR_STEP(kings, back + 1) & empty);
+    *score += mobility * (uint32_t)weights[EVAL_MOBILITY];
+    
+    EvalVector path = empty & promotion_rows[player], reach = empty & 0;
+    for (int i = 0; i < 3; i++) {
+        path = VECTOR_STEP(path, back) | VECTOR_STEP(path, back + 1);
+        reach |= path;
+        path &= empty;
+    }
+    *score += VECTOR_COUNT(men & reach) * (uint32_t)weights[EVAL_RUNAWAY];
+}
+
+static inline __attribute__((always_inline)) void VectorEvaluate(const uint32_t halves[4][EVAL_LANES], const int weights[],
+                                                                 int scores[]) {
+    EvalVector red, black, red_kings, black_kings, red_score, black_score;
+    memcpy(&red, halves[0], sizeof(red));
+    memcpy(&black, halves[1], sizeof(black));
+    memcpy(&red_kings, halves[2], sizeof(red_kings));
+    memcpy(&black_kings, halves[3], sizeof(black_kings));
+    EvalVector empty = ~(red | black);
+    VectorSide(&red, &red_kings, &empty, 0, weights, &red_score);
+    VectorSide(&black, &black_kings, &empty, 1, weights, &black_score);
+    red_score -= black_score;
+    memcpy(scores, &red_score, sizeof(red_score));     // Wrapped unsigned sums are the signed scores
+}
+
+static void EvalKernelScalar(const uint32_t halves[4][EVAL_LANES], const int weights[EVAL_FEATURES], int scores[]) {
+    for (int i = 0; i < EVAL_LANES; i++) {
+        GameState game;
+        game.pieces = halves[0][i] | (Bitboard)halves[1][i] << 32;
+        game.kings = halves[2][i] | (Bitboard)halves[3][i] << 32;
+        game.current_turn = 0;
+        scores[i] = EvaluateFull(&game, weights);
+    }
+}
+
+#if defined(__x86_64__) || defined(__i386__)
+__attribute__((target("avx2"))) static void EvalKernelAVX2(const uint32_t halves[4][EVAL_LANES], const int weights[EVAL_FEATURES],
+                                                        int scores[]) {
+    VectorEvaluate(halves, weights, scores);
+}
+
+__attribute__((target("avx512f"))) static void EvalKernelAVX512(const uint32_t halves[4][EVAL_LANES], const int weights[EVAL_FEATURES],
+                                                             int scores[]) {
+    VectorEvaluate(halves, weights, scores);
+}
+#endif
+
+EvalKernel eval_kernel = EvalKernelScalar;
+const char *eval_kernel_name = "scalar";
+
+void InitEvalKernel() {         // Picks the widest lanes the CPU runs
+#if defined(__x86_64__) || defined(__i386__)
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx512f")) {
+        eval_kernel = EvalKernelAVX512;
+        eval_kernel_name = "avx512";
+    } else if (__builtin_cpu_supports("avx2")) {
+        eval_kernel = EvalKernelAVX2;
+        eval_kernel_name = "avx2";
+    }
+#endif
+}
+
+void EvaluateBatch(GameState *games, int count, const EvalWeights *eval, int scores[]) {     // Same scores as Evaluate, EVAL_LANES at a time
+    uint32_t halves[4][EVAL_LANES];
+    int lane_scores[EVAL_LANES];
+    int i = 0;
+    for (; i + EVAL_LANES <= count; i += EVAL_LANES) {
+        for (int lane = 0; lane < EVAL_LANES; lane++) {
+            halves[0][lane] = SideBits(games[i + lane].pieces, 0);
+            halves[1][lane] = SideBits(games[i + lane].pieces, 1);
+            halves[2][lane] = SideBits(games[i + lane].kings, 0);
+            halves[3][lane] = SideBits(games[i + lane].kings, 1);
+        }
+        eval_kernel(halves, eval->weights, lane_scores);
+        for (int lane = 0; lane < EVAL_LANES; lane++) {
+            scores[i + lane] = games[i + lane].current_turn == 0 ? lane_scores[lane] : -lane_scores[lane];
+        }
+    }
+    for (; i < count; i++) {            // Whatever doesn't fill the lanes
+        scores[i] = EvaluateFull(&games[i], eval->weights);
+    }
+}
+
+// Weights files are "name value" lines in any order, names from eval_names. Missing names keep their weight.
+int LoadWeights(const char *filename, int loaded[EVAL_FEATURES]) {      // 0 if the file can't be read or has a line it doesn't know
+    FILE *file = fopen(filename, "r");
+    if (!file) return 0;
+    int weights[EVAL_FEATURES];
+    memcpy(weights, loaded, sizeof(weights));
+    char line[128], name[32];
+    int value, valid = 1;
+    while (valid && fgets(line, sizeof(line), file)) {
+        if (line[0] == '#' || sscanf(line, "%31s", name) != 1) continue;        // Comments and blank lines
+        int feature = 0;
+        while (feature < EVAL_FEATURES && strcmp(name, eval_names[feature]) != 0) feature++;
+        valid = feature < EVAL_FEATURES && sscanf(line, "%*s %d", &value) == 1;
+        if (valid) weights[feature] = value;
+    }
+    fclose(file);
+    if (!valid) return 0;
+    memcpy(loaded, weights, sizeof(weights));     // Only a whole valid file changes them
+    return 1;
+}
+
+void SetWeights(EvalWeights *eval, const CheckersWeights *weights) {      // NULL for the defaults
+    InitWeights(eval, weights ? weights->values : default_values);
+}
+
+void SaveWeights(FILE *file, const int weights[EVAL_FEATURES]) {
+    for (int i = 0; i < EVAL_FEATURES; i++) {
+        fprintf(file, "%s %d\n", eval_names[i], weights[i]);
+    }
+}
+
+// Search
+// Negamax alpha-beta with iterative deepening. Each thread makes and unmakes move deltas on its own copy
+// of the position, so nothing prints or gets copied. A whole jump sequence is one move, so every ply
+// changes the side to move.
+// Every thread counts into its own CheckersStats and the engine adds them up afterwards, so counting
+// is a plain increment. STAT compiles to nothing with CHECKERS_NO_STATS.
+#ifndef CHECKERS_NO_STATS
+#define STAT(ctx, field, n)     ((ctx)->stats.field += (n))
+#else
+#define STAT(ctx, field, n)     ((void)(n))
+#endif
+#define SCORE_INF   30000
+#define SCORE_WIN   29000       // Winning scores are SCORE_WIN - ply so faster wins score higher
+#define SCORE_TB_WIN 20000      // Tablebase win, plus the evaluation
+#define MAX_PLY     128
+
+typedef CheckersLimits SearchLimits;
+
+typedef struct MctsNode MctsNode;       // Monte Carlo tree search, see below
+
+typedef struct {                // Everything a bot searches with
+    SearchLimits limits;
+    TranspositionTable tt;
+    int threads;
+    Tablebase *tb;              // NULL when none is loaded
+    const EvalWeights *weights; // NULL for the default weights
+    CheckersInfoCallback info;  // Called after every finished depth when set
+    void *info_user;
+    atomic_int stop;            // Set from another thread to end the search early
+    int search_forced;          // Search a forced move anyway, so there's a score to report
+    const History *history;     // Game so far, ending with the position searched. NULL for none
+    int mcts;                   // Search with MctsBestMove instead of alpha-beta, its tree takes over tt's memory
+    int continuing;             // The next search picks up from the last one, so the table isn't aged. Cleared by it
+    int score;                  // Last search: score for the side to move, deepest finished depth, nodes
+    int depth;
+    uint64_t nodes;
+#ifndef CHECKERS_NO_STATS
+    CheckersStats stats;        // Last search
+#endif
+} Engine;
+
+typedef struct {                // What the threads of one search share
+    SearchLimits limits;
+    double deadline;
+    _Atomic uint64_t nodes;     // Added to in batches of 1024
+    atomic_int stop;
+    atomic_int *abort;          // The engine's stop flag
+    CheckersInfoCallback info;
+    void *info_user;
+    double start;
+} SharedSearch;
+
+typedef struct {                // One per search thread, along with its own copy of the position
+    SharedSearch *shared;
+    TranspositionTable *tt;
+    Tablebase *tb;
+    const EvalWeights *weights; // What root.eval and every Evaluate go by
+    GameState root;
+    int thread_id;
+    uint64_t rng;
+    uint64_t nodes;
+    int stopped;
+    int killers[MAX_PLY][2];    // from * 32 + to of quiet moves that caused a cutoff
+    int history[2][32][32];     // [player][from][to], bumped by depth^2 on cutoffs
+    uint64_t keys[CHECKERS_HISTORY + MAX_PLY];      // Game history, then the keys along the search path
+    int root_index;             // Where the root's key is in keys
+    Move best_move;             // Best root move of the iteration in progress
+    Move root_best;             // Best root move of the last finished iteration
+    int best_score;
+    int depth_reached;
+#ifndef CHECKERS_NO_STATS
+    CheckersStats stats;
+#endif
+} SearchContext;
+
+static int CheckLimits(SearchContext *ctx) {       // Polled every 1024 nodes
+    SharedSearch *shared = ctx->shared;
+    uint64_t nodes = atomic_fetch_add(&shared->nodes, 1024) + 1024;
+    if ((shared->limits.max_nodes && nodes >= shared->limits.max_nodes) ||
+        (shared->deadline > 0 && NowSeconds() >= shared->deadline) || atomic_load(shared->abort)) {
+        atomic_store(&shared->stop, 1);
+    }
+    ctx->stopped = atomic_load_explicit(&shared->stop, memory_order_relaxed);
+    return ctx->stopped;
+}
+
+static int OrderMoves(SearchContext *ctx, GameState *game, Move moves[], int scores[], int count, int ply, int hash_move) {
+    int found = 0;          // Returns whether the hash move was among them
+    for (int i = 0; i < count; i++) {
+        int key = moves[i].from * 32 + moves[i].to;
+        if (key == hash_move) {                     // Best move from the hash table before anything else
+            scores[i] = 3000000;
+            found = 1;
+        } else if (moves[i].captures) {             // Captures next, the most pieces first and kings before men
+            uint32_t kings = moves[i].captures & SideBits(game->kings, 1 - game->current_turn);
+            scores[i] = 2000000 + 16 * CountBits(moves[i].captures) + CountBits(kings);
+        } else if (key == ctx->killers[ply][0]) {
+            scores[i] = 1000001;
+        } else if (key == ctx->killers[ply][1]) {
+            scores[i] = 1000000;
+        } else {
+            scores[i] = ctx->history[game->current_turn][moves[i].from][moves[i].to];
+            if (ctx->thread_id > 0) {       // Helper threads shuffle ties so they don't all walk the same tree
+                scores[i] += SplitMix64(&ctx->rng) & 7;
+            }
+        }
+    }
+    return found;
+}
+
+static void PickMove(Move moves[], int scores[], int count, int index) {      // Selection sort one step at a time
+    int best = index;
+    for (int i = index + 1; i < count; i++) {
+        if (scores[i] > scores[best]) best = i;
+    }
+    Move move = moves[index];
+    int score = scores[index];
+    moves[index] = moves[best];
+    scores[index] = scores[best];
+    moves[best] = move;
+    scores[best] = score;
+}
+
+static int ScoreToTT(int score, int ply) {      // Wins are stored relative to the node, not the root
+    if (score >= SCORE_WIN - MAX_PLY) return score + ply;
+    if (score <= -SCORE_WIN + MAX_PLY) return score - ply;
+    return score;
+}
+
+static int ScoreFromTT(int score, int ply) {
+    if (score >= SCORE_WIN - MAX_PLY) return score - ply;
+    if (score <= -SCORE_WIN + MAX_PLY) return score + ply;
+    return score;
+}
+
+static int SearchDrawn(SearchContext *ctx, GameState *game, int ply) {     // Move rule, or back to a position of the game or the path
+    if (game->reversible >= MOVE_RULE) return 1;
+    int index = ctx->root_index + ply;
+    for (int i = index - 4; i >= 0 && i >= index - game->reversible; i -= 2) {
+        if (ctx->keys[i] == game->key) return 1;        // Once is enough here, it can be repeated again
+    }
+    return 0;
+}
+
+int Search(SearchContext *ctx, GameState *game, int depth, int alpha, int beta, int ply) {
+    if ((++ctx->nodes & 1023) == 0 && CheckLimits(ctx)) return 0;
+    ctx->keys[ctx->root_index + ply] = game->key;
+    if (ply > 0 && game->reversible >= 4 && SearchDrawn(ctx, game, ply)) return 0;
+    
+    int hash_move = -1;
+    int alpha_start = alpha;
+    TTEntry entry;
+    STAT(ctx, tt_probes, 1);
+    if (TTProbe(ctx->tt, game->key, &entry)) {
+        STAT(ctx, tt_hits, 1);
+        hash_move = entry.from * 32 + entry.to;
+        int score = ScoreFromTT(entry.score, ply);
+        if (ply > 0 && entry.depth >= depth && (entry.bound == BOUND_EXACT ||
+            (entry.bound == BOUND_LOWER && score >= beta) || (entry.bound == BOUND_UPPER && score <= alpha))) {
+            STAT(ctx, tt_cutoffs, 1);
+            return score;
+        }
+    }
+    
+    if (ctx->tb && ply > 0 && CountBits(game->pieces) <= ctx->tb->max_pieces) {
+        int result = TBProbe(ctx->tb, game);        // Material still counts so won endings make progress
+        if (result == TB_WIN) return SCORE_TB_WIN + Evaluate(game, ctx->weights);
+        if (result == TB_LOSS) return -SCORE_TB_WIN + Evaluate(game, ctx->weights);
+        if (result == TB_DRAW) return 0;
+    }
+    
+    Move moves[MAX_MOVES];
+    int count = GenerateMoves(game, game->current_turn, moves);
+    STAT(ctx, movegen_calls, 1);
+    STAT(ctx, moves_generated, count);
+    
+    if (count == 0) return -SCORE_WIN + ply;        // No moves loses
+    if (ply >= MAX_PLY - 1) return Evaluate(game, ctx->weights);
+    int is_capture = moves[0].captures != 0;
+    STAT(ctx, captures_generated, is_capture ? count : 0);
+    if (depth <= 0 && !is_capture) return Evaluate(game, ctx->weights);      // Captures are forced, so resolve them before evaluating
+    
+    int scores[MAX_MOVES];
+    int hash_found = OrderMoves(ctx, game, moves, scores, count, ply, hash_move);
+    STAT(ctx, tt_collisions, hash_move >= 0 && !hash_found);
+    STAT(ctx, expanded, 1);
+    
+    int best_score = -SCORE_INF;
+    int best_index = -1;
+    for (int i = 0; i < count; i++) {
+        PickMove(moves, scores, count, i);
+        STAT(ctx, moves_searched, 1);
+        MoveDelta delta;
+        GetMoveDelta(game, &moves[i], &delta, ctx->weights);
+        MakeDelta(game, &delta);
+        int score = -Search(ctx, game, depth - 1, -beta, -alpha, ply + 1);
+        UnmakeDelta(game, &delta);
+        if (ctx->stopped) return 0;
+        
+        if (score > best_score) {
+            best_score = score;
+            best_index = i;
+            if (ply == 0) ctx->best_move = moves[i];
+        }
+        if (score > alpha) alpha = score;
+        if (alpha >= beta) {
+            STAT(ctx, cutoffs, 1);
+            STAT(ctx, first_move_cutoffs, i == 0);
+            if (!is_capture) {          // Remember quiet moves that refute this line
+                int key = moves[i].from * 32 + moves[i].to;
+                if (ctx->killers[ply][0] != key) {
+                    ctx->killers[ply][1] = ctx->killers[ply][0];
+                    ctx->killers[ply][0] = key;
                 }
+                ctx->history[game->current_turn][moves[i].from][moves[i].to] += depth * depth;
             }
-            
-            if (IsValidMove(&game, from_row, from_col, to_row, to_col)) {       // Performs the new move when validated
-                MakeMove(&game, from_row, from_col, to_row, to_col);
-                
-                int row_diff = to_row - from_row;
-                if (abs(row_diff) == 2 && CanContinueCapturing(&game, to_row, to_col)) {
-                    chain_jump = 1;
-                    chain_row = to_row;
-                    chain_col = to_col;
-                    printf("Chain jump! Continue capturing.\n");
-                } else {
-                    chain_jump = 0;
-                    chain_row = -1;
-                    chain_col = -1;
-                    game.current_turn = 1;
+            break;
+        }
+    }
+    
+    int bound = best_score >= beta ? BOUND_LOWER : best_score > alpha_start ? BOUND_EXACT : BOUND_UPPER;
+    TTStore(ctx->tt, game->key, depth > 0 ? depth : 0, bound, ScoreToTT(best_score, ply),
+            moves[best_index].from, moves[best_index].to);
+    return best_score;
+}
+
+static int PliesToEnd(int score) {      // How far off a forced result is, 0 if the score isn't one
+    if (score >= SCORE_WIN - MAX_PLY) return SCORE_WIN - score;
+    if (score <= -SCORE_WIN + MAX_PLY) return SCORE_WIN + score;
+    return 0;
+}
+
+static void ReportSearchInfo(SearchContext *ctx) {     // Hands the finished depth to the info callback
+    SharedSearch *shared = ctx->shared;
+    CheckersSearchInfo info;
+    info.depth = ctx->depth_reached;
+    info.score = ctx->best_score;
+    info.plies_to_end = PliesToEnd(ctx->best_score);
+    info.nodes = atomic_load(&shared->nodes) + (ctx->nodes & 1023);
+    info.seconds = NowSeconds() - shared->start;
+    info.book = 0;
+    info.best = ctx->root_best;
+    shared->info(&info, shared->info_user);
+}
+
+static void IterativeDeepening(SearchContext *ctx) {
+    int max_depth = ctx->shared->limits.max_depth > 0 ? ctx->shared->limits.max_depth : MAX_PLY / 2;
+    
+    for (int depth = 1 + (ctx->thread_id & 1); depth <= max_depth; depth++) {      // Odd helpers run a ply ahead
+#ifndef CHECKERS_NO_STATS
+        double start = NowSeconds();
+        uint64_t nodes = ctx->nodes;
+#endif
+        int score = Search(ctx, &ctx->root, depth, -SCORE_INF, SCORE_INF, 0);
+        if (ctx->stopped) break;        // Partial iterations are thrown away
+#ifndef CHECKERS_NO_STATS
+        if (depth <= CHECKERS_MAX_ITERATIONS) {
+            ctx->stats.iteration_seconds[depth - 1] = NowSeconds() - start;
+            ctx->stats.iteration_nodes[depth - 1] = ctx->nodes - nodes;
+            ctx->stats.iterations = depth;
+        }
+#endif
+        ctx->best_score = score;
+        ctx->depth_reached = depth;
+        ctx->root_best = ctx->best_move;
+        if (ctx->thread_id == 0 && ctx->shared->info) ReportSearchInfo(ctx);
+        if (score >= SCORE_WIN - MAX_PLY || score <= -SCORE_WIN + MAX_PLY) break;     // Found a forced result
+    }
+}
+
+#ifndef CHECKERS_NO_STATS
+static void AddStats(CheckersStats *total, SearchContext *contexts, int threads) {      // Iterations come from the main thread
+    *total = contexts[0].stats;
+    for (int i = 1; i < threads; i++) {
+        CheckersStats *part = &contexts[i].stats;
+        total->movegen_calls += part->movegen_calls;
+        total->moves_generated += part->moves_generated;
+        total->captures_generated += part->captures_generated;
+        total->tt_probes += part->tt_probes;
+        total->tt_hits += part->tt_hits;
+        total->tt_cutoffs += part->tt_cutoffs;
+        total->tt_collisions += part->tt_collisions;
+        total->expanded += part->expanded;
+        total->moves_searched += part->moves_searched;
+        total->cutoffs += part->cutoffs;
+        total->first_move_cutoffs += part->first_move_cutoffs;
+    }
+    for (int i = 0; i < threads; i++) {
+        total->nodes += contexts[i].nodes;
+    }
+}
+#endif
+
+static void *SearchThreadMain(void *arg) {
+    IterativeDeepening(arg);
+    return NULL;
+}
+
+int SearchBestMove(Engine *engine, GameState *game, Move *best_move) {    // Returns 0 if no move
+    const MoveCache *legal = LegalMoves(game);      // Usually the position the front end just checked
+    const Move *moves = legal->moves;
+    int count = legal->count;
+    engine->score = count == 0 ? -SCORE_WIN : 0;
+    engine->depth = 0;
+    engine->nodes = 0;
+#ifndef CHECKERS_NO_STATS
+    memset(&engine->stats, 0, sizeof(engine->stats));
+#endif
+    if (count == 0) return 0;
+    *best_move = moves[0];
+    if (count == 1 && !engine->search_forced) return 1;     // Nothing to think about
+    
+    // Lazy SMP: every thread runs its own iterative deepening on its own copy of the position, and they
+    // help each other through the shared hash table. The first thread's answer is the one played.
+    int threads = engine->threads > 0 ? engine->threads : 1;
+    SharedSearch shared;
+    shared.limits = engine->limits;
+    shared.deadline = engine->limits.time_ms > 0 ? NowSeconds() + engine->limits.time_ms / 1000.0 : 0;
+    atomic_init(&shared.nodes, 0);
+    atomic_init(&shared.stop, 0);
+    shared.abort = &engine->stop;
+    shared.info = engine->info;
+    shared.info_user = engine->info_user;
+    shared.start = NowSeconds();
+    if (!engine->continuing) engine->tt.age++;      // Entries of earlier searches become the first to be replaced
+    
+    SearchContext *contexts = calloc(threads, sizeof(SearchContext));
+    pthread_t *handles = calloc(threads, sizeof(pthread_t));
+    if (!contexts || !handles) {
+        free(contexts);
+        free(handles);
+        return 1;
+    }
+    
+    uint64_t seed = (uint64_t)time(NULL) ^ game->key;
+    const EvalWeights *weights = engine->weights ? engine->weights : &default_weights;
+    for (int i = 0; i < threads; i++) {
+        SearchContext *ctx = &contexts[i];
+        memset(ctx->killers, -1, sizeof(ctx->killers));
+        ctx->shared = &shared;
+        ctx->tt = &engine->tt;
+        ctx->tb = engine->tb;
+        ctx->weights = weights;
+        ctx->root = *game;
+        ctx->root.eval = MaterialEval(game, weights);       // The position came with the default weights
+        ctx->thread_id = i;
+        ctx->rng = SplitMix64(&seed);
+        ctx->root_best = moves[0];
+        const History *history = engine->history;
+        if (history && history->count > 0 && HistoryKey(history, 0) == game->key) {
+            for (int back = 0; back < history->count; back++) {        // Unrolled from the ring, oldest first
+                ctx->keys[history->count - 1 - back] = HistoryKey(history, back);
+            }
+            ctx->root_index = history->count - 1;
+        }
+    }
+    
+    int started = 1;
+    for (int i = 1; i < threads; i++) {
+        if (pthread_create(&handles[i], NULL, SearchThreadMain, &contexts[i]) != 0) break;
+        started++;
+    }
+    IterativeDeepening(&contexts[0]);
+    atomic_store(&shared.stop, 1);      // Main thread is done, call off the helpers
+    for (int i = 1; i < started; i++) {
+        pthread_join(handles[i], NULL);
+    }
+    
+    *best_move = contexts[0].root_best;
+    engine->score = contexts[0].best_score;
+    engine->depth = contexts[0].depth_reached;
+    for (int i = 0; i < threads; i++) {
+        engine->nodes += contexts[i].nodes;
+    }
+#ifndef CHECKERS_NO_STATS
+    AddStats(&engine->stats, contexts, threads);
+    engine->stats.seconds = NowSeconds() - shared.start;
+#endif
+    free(contexts);
+    free(handles);
+    return 1;
+}
+
+// Monte Carlo tree search
+// The other kind of bot: UCT over a tree that grows one expansion at a time, with random games played
+// to the end on the bitboards to score each leaf. All threads grow the same tree. A thread going down
+// a path marks every node on it in flight, and selection counts each of those as MCTS_VIRTUAL_LOSS lost
+// visits until the playout is scored, so the others spread out to other branches instead of piling onto
+// the one being looked at. Only finished playouts count toward expanding a leaf or picking the move.
+// Nodes come out of an arena, a whole family of children with a single atomic add, and the arena is
+// simply reset for the next search. It is the hash table's memory, which MCTS has no use for, so -hash
+// sizes the tree and an MCTS engine takes no more memory than an alpha-beta one. Once it's full the
+// tree stops growing and the playouts go on from its leaves. The move played is the most visited one. Repeats aren't looked for here, the move
+// rule is what ends the shuffling games.
+#define MCTS_VIRTUAL_LOSS   3
+#define MCTS_EXPLORE        1.0         // UCT constant, scores are 0 to 1
+#define MCTS_EXPAND_VISITS  8           // A leaf plays out this many games before it gets children
+#define MCTS_MAX_DEPTH      256
+#define MCTS_BATCH          16          // Playouts between limit checks
+
+struct MctsNode {
+    _Atomic uint32_t visits;    // Finished playouts through here
+    _Atomic uint32_t score;     // 2 per win and 1 per draw, for the side that moved into this node
+    _Atomic uint32_t children;  // Index of the first child in the arena, 0 until expanded
+    atomic_ushort in_flight;    // Playouts under way through here, the virtual losses
+    uint16_t child_count;
+    atomic_uchar expanding;     // Taken by the one thread that expands it
+    uint8_t from, to;           // Move into this node
+    uint32_t captures;
+};
+
+typedef struct {                // One search's view of the arena
+    MctsNode *nodes;            // nodes[0] is the root
+    uint64_t capacity;
+    _Atomic uint64_t used;
+} MctsTree;
+
+typedef struct {                // One per thread
+    SharedSearch *shared;
+    MctsTree *tree;
+    GameState root;
+    uint64_t rng;
+    uint64_t playouts;
+    int depth;                  // Longest path down the tree so far
+} MctsContext;
+
+// Random game from game to the end on the boards alone: no keys, no evaluation, no move lists. A capture
+// hops in a random direction until it can't, a quiet move is picked evenly from all of them. Returns the
+// winner, or -1 for a draw by the move rule.
+static int Playout(GameState *game, uint64_t *rng) {
+    for (;;) {
+        int player = game->current_turn;
+        if (game->reversible >= MOVE_RULE) return -1;
+        uint32_t opp = SideBits(game->pieces, 1 - player);
+        uint32_t kings = SideBits(game->kings, player), empty = EmptySquares(game);
+        uint32_t jumpers = GetJumpers(game, player);
+        int from, to;
+        uint32_t taken = 0;
+        if (jumpers) {
+            for (int pick = SplitMix64(rng) % CountBits(jumpers); pick > 0; pick--) jumpers &= jumpers - 1;
+            from = to = __builtin_ctz(jumpers);
+            int king = (kings >> from) & 1;
+            int dirs = king ? 0xF : forward_dirs[player];
+            for (;;) {
+                int options[4], count = 0;
+                for (int dir = 0; dir < 4; dir++) {
+                    int over = square_jump_over[to][dir];
+                    if (((dirs >> dir) & 1) && over != NO_SQUARE && ((opp >> over) & 1) && ((empty >> square_landing[to][dir]) & 1)) {
+                        options[count++] = dir;
+                    }
                 }
-            } else {
-                printf("Invalid move ");
-                if (HasForcedCapture(&game, game.current_turn)) {
-                    printf("You must capture \n");
-                } 
+                if (count == 0) break;
+                int dir = options[SplitMix64(rng) % count];
+                int over = square_jump_over[to][dir];
+                opp &= ~(1U << over);
+                taken |= 1U << over;
+                empty = (empty | 1U << over | 1U << to) & ~(1U << square_landing[to][dir]);
+                to = square_landing[to][dir];
+                if (!king && PromotesOn(player, to)) break;         // Kinging ends the move
+            }
+        } else {
+            uint32_t land[4];
+            int total = 0;
+            for (int dir = 0; dir < 4; dir++) {
+                land[dir] = Step(MoversFor(game, player, dir), dir) & empty;
+                total += CountBits(land[dir]);
             }
-        } else {        // Calls bot to move then switch
-            MakeBotMove(&game);
-            game.current_turn = 0;
-            chain_jump = 0;
+            if (total == 0) return 1 - player;      // No move loses
+            int pick = SplitMix64(rng) % total, dir = 0;
+            while (pick >= CountBits(land[dir])) pick -= CountBits(land[dir++]);
+            for (; pick > 0; pick--) land[dir] &= land[dir] - 1;
+            to = __builtin_ctz(land[dir]);
+            from = __builtin_ctz(Step(1U << to, 3 - dir));
+        }
+        
+        int shift = 32 * player;
+        Bitboard moved = (1ULL << (from + shift)) ^ (1ULL << (to + shift));
+        Bitboard captured = (Bitboard)taken << (32 * (1 - player));
+        int is_king = (kings >> from) & 1;
+        game->pieces ^= moved ^ captured;
+        game->kings &= ~captured;
+        if (is_king) {
+            game->kings ^= moved;
+        } else if (PromotesOn(player, to)) {
+            game->kings |= 1ULL << (to + shift);
+        }
+        game->reversible = taken || !is_king ? 0 : game->reversible + 1;
+        game->current_turn ^= 1;
+    }
+}
+
+// Gives node its children, one per legal move of game. Returns the first one's index, 0 if another
+// thread has it, the game is over there or the arena is full. Only the first caller ever tries.
+static uint32_t MctsExpand(MctsTree *tree, MctsNode *node, GameState *game) {
+    if (atomic_exchange(&node->expanding, 1)) return 0;
+    Move moves[MAX_MOVES];
+    int count = GenerateMoves(game, game->current_turn, moves);
+    if (count == 0) return 0;
+    uint64_t first = atomic_fetch_add(&tree->used, count);
+    if (first + count > tree->capacity) return 0;
+    for (int i = 0; i < count; i++) {
+        MctsNode *child = &tree->nodes[first + i];
+        atomic_init(&child->visits, 0);
+        atomic_init(&child->in_flight, 0);
+        atomic_init(&child->score, 0);
+        atomic_init(&child->children, 0);
+        atomic_init(&child->expanding, 0);
+        child->child_count = 0;
+        child->from = moves[i].from;
+        child->to = moves[i].to;
+        child->captures = moves[i].captures;
+    }
+    node->child_count = count;
+    atomic_store_explicit(&node->children, (uint32_t)first, memory_order_release);
+    return first;
+}
+
+static inline uint32_t MctsSelectVisits(MctsNode *node) {      // Finished visits plus the virtual losses
+    return atomic_load_explicit(&node->visits, memory_order_relaxed) +
+           MCTS_VIRTUAL_LOSS * atomic_load_explicit(&node->in_flight, memory_order_relaxed);
+}
+
+static uint32_t MctsSelect(MctsTree *tree, MctsNode *node, uint32_t first) {     // UCT pick among the children
+    double log_visits = log(MctsSelectVisits(node) + 1);
+    uint32_t best = first;
+    double best_value = -1;
+    for (uint32_t i = first; i < first + node->child_count; i++) {
+        MctsNode *child = &tree->nodes[i];
+        uint32_t visits = MctsSelectVisits(child);
+        if (visits == 0) return i;          // Everything gets tried once first
+        double value = atomic_load_explicit(&child->score, memory_order_relaxed) / (2.0 * visits) +
+                       MCTS_EXPLORE * sqrt(log_visits / visits);
+        if (value > best_value) {
+            best_value = value;
+            best = i;
+        }
+    }
+    return best;
+}
+
+static void MctsIteration(MctsContext *ctx) {      // Down the tree, one playout, and its result back up
+    MctsTree *tree = ctx->tree;
+    GameState game = ctx->root;
+    uint32_t path[MCTS_MAX_DEPTH];
+    int length = 1;
+    path[0] = 0;
+    atomic_fetch_add(&tree->nodes[0].in_flight, 1);
+    
+    while (length < MCTS_MAX_DEPTH) {
+        MctsNode *node = &tree->nodes[path[length - 1]];
+        uint32_t first = atomic_load_explicit(&node->children, memory_order_acquire);
+        if (!first && atomic_load_explicit(&node->visits, memory_order_relaxed) >= MCTS_EXPAND_VISITS &&
+            game.reversible < MOVE_RULE) {
+            first = MctsExpand(tree, node, &game);
+        }
+        if (!first) break;
+        uint32_t index = MctsSelect(tree, node, first);
+        MctsNode *child = &tree->nodes[index];
+        Move move;
+        move.from = child->from;
+        move.to = child->to;
+        move.captures = child->captures;
+        MoveDelta delta;
+        GetMoveDelta(&game, &move, &delta, &default_weights);      // Playouts don't look at eval
+        MakeDelta(&game, &delta);
+        atomic_fetch_add(&child->in_flight, 1);
+        path[length++] = index;
+    }
+    if (length - 1 > ctx->depth) ctx->depth = length - 1;
+    
+    int winner = Playout(&game, &ctx->rng);
+    int mover = ctx->root.current_turn;         // Moved into path[1]
+    atomic_fetch_add(&tree->nodes[0].visits, 1);
+    atomic_fetch_sub(&tree->nodes[0].in_flight, 1);
+    for (int i = 1; i < length; i++, mover ^= 1) {
+        MctsNode *node = &tree->nodes[path[i]];
+        atomic_fetch_add(&node->score, winner < 0 ? 1 : winner == mover ? 2 : 0);
+        atomic_fetch_add(&node->visits, 1);
+        atomic_fetch_sub(&node->in_flight, 1);
+    }
+}
+
+static void *MctsThreadMain(void *arg) {
+    MctsContext *ctx = arg;
+    SharedSearch *shared = ctx->shared;
+    while (!atomic_load_explicit(&shared->stop, memory_order_relaxed)) {
+        for (int i = 0; i < MCTS_BATCH; i++) {
+            MctsIteration(ctx);
+        }
+        ctx->playouts += MCTS_BATCH;
+        uint64_t playouts = atomic_fetch_add(&shared->nodes, MCTS_BATCH) + MCTS_BATCH;
+        if ((shared->limits.max_nodes && playouts >= shared->limits.max_nodes) ||
+            (shared->deadline > 0 && NowSeconds() >= shared->deadline) || atomic_load(shared->abort)) {
+            atomic_store(&shared->stop, 1);
         }
     }
+    return NULL;
+}
+
+int MctsBestMove(Engine *engine, GameState *game, Move *best_move) {     // Returns 0 if no move. max_nodes counts playouts
+    const MoveCache *legal = LegalMoves(game);
+    int count = legal->count;
+    double start = NowSeconds();
+    engine->score = count == 0 ? -SCORE_WIN : 0;
+    engine->depth = 0;
+    engine->nodes = 0;
+#ifndef CHECKERS_NO_STATS
+    memset(&engine->stats, 0, sizeof(engine->stats));
+#endif
+    if (count == 0) return 0;
+    *best_move = legal->moves[0];
+    if (count == 1 && !engine->search_forced) return 1;
+    Move moves[MAX_MOVES];          // The root's children are in this order, the cache may be gone by the end
+    memcpy(moves, legal->moves, count * sizeof(Move));
     
-    PrintBoard(&game);
-    printf("\nGame Over ");
+    MctsTree tree;
+    tree.nodes = (MctsNode *)engine->tt.buckets;        // Cleared again when the engine goes back to alpha-beta
+    tree.capacity = (engine->tt.mask + 1) * sizeof(TTBucket) / sizeof(MctsNode);
+    if (tree.capacity > UINT32_MAX) tree.capacity = UINT32_MAX;
+    if (!tree.nodes || tree.capacity <= (uint64_t)count) return 1;
+    atomic_init(&tree.used, 1);
+    memset(&tree.nodes[0], 0, sizeof(MctsNode));
+    MctsExpand(&tree, &tree.nodes[0], game);
     
-    Bitboard red_pieces = game.pieces & 0xFFFFFFFF;
-    Bitboard black_pieces = (game.pieces >> 32) & 0xFFFFFFFF;
+    int threads = engine->threads > 0 ? engine->threads : 1;
+    SharedSearch shared;
+    shared.limits = engine->limits;
+    shared.deadline = engine->limits.time_ms > 0 ? start + engine->limits.time_ms / 1000.0 : 0;
+    atomic_init(&shared.nodes, 0);
+    atomic_init(&shared.stop, 0);
+    shared.abort = &engine->stop;
+    shared.start = start;
+    MctsContext *contexts = calloc(threads, sizeof(MctsContext));
+    pthread_t *handles = calloc(threads, sizeof(pthread_t));
+    if (!contexts || !handles) {
+        free(contexts);
+        free(handles);
+        return 1;
+    }
     
-    if (red_pieces == 0) {      // Conditions: All pieces for player is gone, no valid moves exist, or draw
-        printf("Bot wins!\n");
-    } else if (black_pieces == 0) {
-        printf("You win! \n");
-    } else if (!HasValidMoves(&game, game.current_turn)) {
-        printf("%s has no moves ", game.current_turn == 0 ? "You" : "Bot");
-        printf("%s wins\n", game.current_turn == 0 ? "Bot" : "You");
-    } else {
-        printf("Draw\n");
+    uint64_t seed = (uint64_t)time(NULL) ^ game->key;
+    for (int i = 0; i < threads; i++) {
+        contexts[i].shared = &shared;
+        contexts[i].tree = &tree;
+        contexts[i].root = *game;
+        contexts[i].rng = SplitMix64(&seed);
+    }
+    int started = 1;
+    for (int i = 1; i < threads; i++) {
+        if (pthread_create(&handles[i], NULL, MctsThreadMain, &contexts[i]) != 0) break;
+        started++;
+    }
+    MctsThreadMain(&contexts[0]);
+    for (int i = 1; i < started; i++) {
+        pthread_join(handles[i], NULL);
     }
     
-    return 0;
-}
\ No newline at end of file
+    MctsNode *root = &tree.nodes[0];
+    int best = 0;
+    for (int i = 1; i < root->child_count; i++) {
+        if (atomic_load(&tree.nodes[1 + i].visits) > atomic_load(&tree.nodes[1 + best].visits)) best = i;
+    }
+    MctsNode *chosen = &tree.nodes[1 + best];
+    uint32_t visits = atomic_load(&chosen->visits);
+    *best_move = moves[best];
+    engine->score = visits ? (int)(1000 * (atomic_load(&chosen->score) / (double)visits - 1)) : 0;      // -1000 to 1000
+    for (int i = 0; i < threads; i++) {
+        engine->nodes += contexts[i].playouts;
+        if (contexts[i].depth > engine->depth) engine->depth = contexts[i].depth;
+    }
+#ifndef CHECKERS_NO_STATS
+    uint64_t used = atomic_load(&tree.used);
+    engine->stats.nodes = engine->nodes;
+    engine->stats.playouts = engine->nodes;
+    engine->stats.tree_nodes = used < tree.capacity ? used : tree.capacity;
+    engine->stats.seconds = NowSeconds() - start;
+#endif
+    if (engine->info) {
+        CheckersSearchInfo info;
+        info.depth = engine->depth;
+        info.score = engine->score;
+        info.plies_to_end = 0;
+        info.nodes = engine->nodes;
+        info.seconds = NowSeconds() - start;
+        info.book = 0;
+        info.best = *best_move;
+        engine->info(&info, engine->info_user);
+    }
+    free(contexts);
+    free(handles);
+    return 1;
+}
+
+// Game records
+// Whole games in a packed binary stream, one byte per hop:
+//   bits 0-4 starting square, bits 5-6 direction, bit 7 set for a jump
+// A quiet move or single jump is one byte, each extra hop of a jump sequence one more. Moves aren't
+// marked: a jump that starts where the last one landed continues it, the next mover never starts there.
+// Files are appended to record by record and read back through mmap, a reader just walks the bytes.
+// File: magic, version. Record: hop count (uint16), result (0 red won, 1 black won, 2 draw),
+// flags, [pieces, kings, turn when RECORD_CUSTOM_START], hop bytes.
+#define RECORD_MAGIC        0x31474B43U         // "CKG1"
+#define RECORD_VERSION      1
+#define RECORD_CUSTOM_START 1
+#define RECORD_HEADER_SIZE  4
+#define RECORD_START_SIZE   17
+#define RECORD_HOP_JUMP     0x80
+
+typedef struct {
+    FILE *file;
+} RecordWriter;
+
+typedef struct {
+    const uint8_t *data;        // Mapped file or a buffer in memory
+    size_t size;
+    size_t pos;
+    int mapped;
+} RecordReader;
+
+typedef struct {
+    int result;
+    GameState start;
+    const uint8_t *hops;
+    int count;
+} GameRecord;
+
+uint8_t EncodeHop(int from, int to) {
+    int from_row, from_col, to_row, to_col;
+    bitpos_to_board(from, &from_row, &from_col);
+    bitpos_to_board(to, &to_row, &to_col);
+    int dir = (to_row > from_row) * 2 + (to_col > from_col);       // Same order as UP_LEFT .. DOWN_RIGHT
+    return from | dir << 5 | (abs(to_row - from_row) == 2 ? RECORD_HOP_JUMP : 0);
+}
+
+int DecodeHop(uint8_t hop, int *from, int *to) {        // Returns 0 if the hop runs off the board
+    int dir = (hop >> 5) & 3;
+    int land = (hop & RECORD_HOP_JUMP) ? square_landing[hop & 31][dir] : square_neighbour[hop & 31][dir];
+    if (land == NO_SQUARE) return 0;
+    *from = hop & 31;
+    *to = land;
+    return 1;
+}
+
+int EncodeMove(const Move *move, uint8_t *out) {        // Returns the hop count
+    int from = move->from;
+    for (int i = 0; i < move->hops; i++) {
+        out[i] = EncodeHop(from, move->path[i]);
+        from = move->path[i];
+    }
+    return move->hops;
+}
+
+int DecodeMove(const uint8_t *hops, int count, Move *move) {     // Returns the hops used, 0 if one runs off the board
+    int from, to, used = 0;
+    if (count < 1 || !DecodeHop(hops[0], &from, &to)) return 0;
+    StartMove(move, from);
+    do {
+        int jump = hops[used] & RECORD_HOP_JUMP;
+        AddHop(move, to, jump ? square_neighbour[from][(hops[used] >> 5) & 3] : -1);
+        used++;
+        if (!jump || used >= count || used >= MAX_HOPS || !(hops[used] & RECORD_HOP_JUMP) ||
+            (hops[used] & 31) != to) break;
+    } while (DecodeHop(hops[used], &from, &to));
+    return used;
+}
+
+int RecordWriterOpen(RecordWriter *writer, const char *filename) {     // Appends, a new file gets the header first
+    writer->file = fopen(filename, "ab");
+    if (!writer->file) {
+        printf("Error: Could not open file '%s' for writing\n", filename);
+        return 0;
+    }
+    if (ftell(writer->file) == 0) {
+        uint32_t header[2] = {RECORD_MAGIC, RECORD_VERSION};
+        fwrite(header, sizeof(header), 1, writer->file);
+    }
+    return 1;
+}
+
+int EncodeRecordHeader(uint8_t *out, int result, GameState *start, int count) {    // Returns bytes used, start NULL for the usual opening
+    out[0] = count & 0xFF;
+    out[1] = count >> 8;
+    out[2] = result;
+    out[3] = start ? RECORD_CUSTOM_START : 0;
+    if (!start) return RECORD_HEADER_SIZE;
+    memcpy(out + 4, &start->pieces, 8);
+    memcpy(out + 12, &start->kings, 8);
+    out[20] = start->current_turn;
+    return RECORD_HEADER_SIZE + RECORD_START_SIZE;
+}
+
+int RecordWriterAppend(RecordWriter *writer, int result, GameState *start, const uint8_t *hops, int count) {
+    uint8_t header[RECORD_HEADER_SIZE + RECORD_START_SIZE];
+    int length = EncodeRecordHeader(header, result, start, count);
+    return fwrite(header, 1, length, writer->file) == (size_t)length &&
+           fwrite(hops, 1, count, writer->file) == (size_t)count;
+}
+
+void RecordWriterClose(RecordWriter *writer) {
+    fclose(writer->file);
+    writer->file = NULL;
+}
+
+int RecordReaderOpen(RecordReader *reader, const char *filename) {
+    int fd = open(filename, O_RDONLY);
+    if (fd < 0) {
+        printf("Error: Could not open file '%s' for reading\n", filename);
+        return 0;
+    }
+    struct stat st;
+    if (fstat(fd, &st) != 0 || st.st_size < 8) {
+        printf("Error: Invalid game record file '%s'\n", filename);
+        close(fd);
+        return 0;
+    }
+    void *map = mmap(NULL, st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (map == MAP_FAILED) {
+        printf("Error: Could not map '%s'\n", filename);
+        return 0;
+    }
+    madvise(map, st.st_size, MADV_SEQUENTIAL);
+    
+    const uint32_t *header = map;
+    if (header[0] != RECORD_MAGIC || header[1] != RECORD_VERSION) {
+        printf("Error: Invalid game record file '%s'\n", filename);
+        munmap(map, st.st_size);
+        return 0;
+    }
+    reader->data = map;
+    reader->size = st.st_size;
+    reader->pos = 8;
+    reader->mapped = 1;
+    return 1;
+}
+
+void RecordReaderMemory(RecordReader *reader, const uint8_t *data, size_t size) {     // Records without the file header
+    reader->data = data;
+    reader->size = size;
+    reader->pos = 0;
+    reader->mapped = 0;
+}
+
+void RecordReaderClose(RecordReader *reader) {
+    if (reader->mapped) munmap((void *)reader->data, reader->size);
+    reader->data = NULL;
+}
+
+int RecordReaderNext(RecordReader *reader, GameRecord *record) {       // Returns 0 at the end or on a cut off record
+    const uint8_t *p = reader->data + reader->pos;
+    size_t left = reader->size - reader->pos;
+    if (left < RECORD_HEADER_SIZE) return 0;
+    
+    record->count = p[0] | p[1] << 8;
+    record->result = p[2];
+    size_t length = RECORD_HEADER_SIZE + ((p[3] & RECORD_CUSTOM_START) ? RECORD_START_SIZE : 0);
+    if (left < length + record->count) return 0;
+    
+    if (p[3] & RECORD_CUSTOM_START) {
+        memcpy(&record->start.pieces, p + 4, 8);
+        memcpy(&record->start.kings, p + 12, 8);
+        record->start.current_turn = p[20] & 1;
+        ComputeState(&record->start);
+    } else {
+        InitializeGame(&record->start);
+    }
+    record->hops = p + length;
+    reader->pos += length + record->count;
+    return 1;
+}
+
+int IsLegalMove(GameState *game, const Move *move) {
+    const MoveCache *legal = LegalMoves(game);
+    for (int i = 0; i < legal->count; i++) {
+        if (SameMove(&legal->moves[i], move)) return 1;
+    }
+    return 0;
+}
+
+int ReplayRecord(GameRecord *record, GameState *game, int check) {      // Plays the hops onto game, 0 if a move is illegal
+    *game = record->start;
+    for (int i = 0; i < record->count;) {
+        Move move;
+        int used = DecodeMove(record->hops + i, record->count - i, &move);
+        if (!used || (check && !IsLegalMove(game, &move))) return 0;
+        ApplyMove(game, &move);
+        i += used;
+    }
+    return 1;
+}
+
+void PrintRecordMoves(FILE *file, GameRecord *record) {        // "1-0 c3-d4 f6-e5 ..." with jump sequences joined up
+    static const char *results[3] = {"1-0", "0-1", "1/2"};
+    fputs(results[record->result % 3], file);
+    
+    for (int i = 0; i < record->count;) {
+        Move move;
+        int used = DecodeMove(record->hops + i, record->count - i, &move);
+        if (!used) break;
+        fputc(' ', file);
+        PrintMove(file, &move);
+        i += used;
+    }
+    fputc('\n', file);
+}
+
+int CheckersReplay(const char *filename) {          // Replays every game in an archive, checking each hop
+    RecordReader reader;
+    if (!RecordReaderOpen(&reader, filename)) return 0;
+    double start = NowSeconds();
+    uint64_t games = 0, hops = 0, invalid = 0;
+    uint64_t results[3] = {0, 0, 0};
+    GameRecord record;
+    
+    while (RecordReaderNext(&reader, &record)) {
+        GameState game;
+        if (!ReplayRecord(&record, &game, 1)) invalid++;
+        results[record.result % 3]++;
+        hops += record.count;
+        games++;
+    }
+    double elapsed = NowSeconds() - start;
+    if (reader.pos != reader.size) {
+        printf("Warning: %zu bytes left over at the end\n", reader.size - reader.pos);
+    }
+    RecordReaderClose(&reader);
+    
+    printf("Games: %llu (red %llu, black %llu, draws %llu, invalid %llu)\n", (unsigned long long)games,
+           (unsigned long long)results[0], (unsigned long long)results[1], (unsigned long long)results[2],
+           (unsigned long long)invalid);
+    printf("Hops: %llu\n", (unsigned long long)hops);
+    printf("Time: %.3f s\n", elapsed);
+    printf("Games/sec: %.0f\n", elapsed > 0 ? games / elapsed : 0.0);
+    return 1;
+}
+
+// Opening book
+// A flat file of (position key, move, weight) records sorted by key, mapped into memory and binary
+// searched, so a probe touches a handful of records and never parses anything. Moves are stored by
+// their start and final landing square. The builder plays self-play games with a
+// shallow search, picks a random move now and then to spread out, and can add the games of a record
+// archive. Every early move scores by how its game ended for the side that played it (2 win, 1 draw,
+// 0 loss).
+#define BOOK_MAGIC  0x324B4243U         // "CBK2", CBK1 stored the first hop of a jump sequence
+
+typedef struct __attribute__((packed)) {
+    uint64_t key;
+    uint8_t from, to;
+    uint16_t weight;
+} BookEntry;
+
+typedef struct {
+    uint32_t magic;
+    uint32_t unused;
+    uint64_t count;
+} BookHeader;
+
+typedef struct {
+    const uint8_t *map;
+    size_t size;
+    const BookEntry *entries;
+    uint64_t count;
+} OpeningBook;
+
+int BookOpen(OpeningBook *book, const char *filename) {
+    int fd = open(filename, O_RDONLY);
+    if (fd < 0) return 0;
+    struct stat st;
+    if (fstat(fd, &st) != 0 || st.st_size < (off_t)sizeof(BookHeader)) {
+        close(fd);
+        return 0;
+    }
+    void *map = mmap(NULL, st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (map == MAP_FAILED) return 0;
+    
+    const BookHeader *header = map;
+    if (header->magic != BOOK_MAGIC || sizeof(BookHeader) + header->count * sizeof(BookEntry) > (uint64_t)st.st_size) {
+        munmap(map, st.st_size);
+        return 0;
+    }
+    book->map = map;
+    book->size = st.st_size;
+    book->entries = (const BookEntry *)((const uint8_t *)map + sizeof(BookHeader));
+    book->count = header->count;
+    return 1;
+}
+
+void BookClose(OpeningBook *book) {
+    munmap((void *)book->map, book->size);
+    book->map = NULL;
+    book->count = 0;
+}
+
+int BookProbe(OpeningBook *book, GameState *game, uint64_t *rng, Move *move) {     // Weighted pick among the stored moves
+    uint64_t low = 0, high = book->count;
+    while (low < high) {                    // First record with this key
+        uint64_t mid = (low + high) / 2;
+        if (book->entries[mid].key < game->key) {
+            low = mid + 1;
+        } else {
+            high = mid;
+        }
+    }
+    
+    uint64_t total = 0, end = low;
+    while (end < book->count && book->entries[end].key == game->key) {
+        total += book->entries[end++].weight;
+    }
+    if (total == 0) return 0;
+    
+    uint64_t pick = SplitMix64(rng) % total;
+    uint64_t i = low;
+    while (pick >= book->entries[i].weight) {
+        pick -= book->entries[i++].weight;
+    }
+    
+    Move moves[MAX_MOVES];              // Only trust it if it's legal here, keys can collide
+    int count = GenerateMoves(game, game->current_turn, moves);
+    for (int j = 0; j < count; j++) {
+        if (moves[j].from == book->entries[i].from && moves[j].to == book->entries[i].to) {
+            *move = moves[j];
+            return 1;
+        }
+    }
+    return 0;
+}
+
+typedef struct {                // Builder side, weights added up before they're clamped to 16 bits
+    uint64_t key;
+    uint8_t from, to;
+    uint32_t weight;
+} BookCount;
+
+static int CompareBookCounts(const void *a, const void *b) {
+    const BookCount *x = a, *y = b;
+    if (x->key != y->key) return x->key < y->key ? -1 : 1;
+    if (x->from != y->from) return x->from - y->from;
+    return x->to - y->to;
+}
+
+int CheckersBookBuild(int games, int plies, const char *archive, const char *filename, const CheckersWeights *weights) {
+    RecordReader reader;
+    if (archive && !RecordReaderOpen(&reader, archive)) return 0;
+    EvalWeights eval;
+    SetWeights(&eval, weights);
+    Engine engine = {.limits = {.max_depth = 6}, .threads = 1, .weights = &eval};     // Shallow, the book only needs a sensible line
+    if (!TTInit(&engine.tt, 16)) {
+        printf("Error: Could not allocate the hash table\n");
+        return 0;
+    }
+    uint64_t rng = (uint64_t)time(NULL);
+    size_t capacity = (size_t)games * plies + (archive ? reader.size : 0) + 1, used = 0;     // At most one per hop byte
+    BookCount *counts = malloc(capacity * sizeof(BookCount));
+    int *movers = malloc(plies * sizeof(int));
+    if (!counts || !movers) return 0;
+    double start = NowSeconds();
+    
+    for (int g = 0; g < games; g++) {
+        GameState game;
+        InitializeGame(&game);
+        History history;
+        HistoryStart(&history, &game);
+        engine.history = &history;
+        size_t first = used;
+        int ply = 0;
+        
+        while (HasValidMoves(&game, game.current_turn) && !IsDrawn(&history, &game) && ply < 200) {    // Games that drag on are called drawn
+            engine.limits.max_depth = ply < plies ? 6 : 4;
+            Move move;
+            Move moves[MAX_MOVES];
+            int count = GenerateMoves(&game, game.current_turn, moves);
+            if (ply < plies && SplitMix64(&rng) % 4 == 0) {
+                move = moves[SplitMix64(&rng) % count];         // Explore
+            } else {
+                SearchBestMove(&engine, &game, &move);
+            }
+            if (ply < plies) {
+                counts[used].key = game.key;
+                counts[used].from = move.from;
+                counts[used].to = move.to;
+                movers[used - first] = game.current_turn;
+                used++;
+            }
+            ApplyMove(&game, &move);
+            HistoryPush(&history, &game);
+            ply++;
+        }
+        
+        int winner = HasValidMoves(&game, game.current_turn) ? -1 : 1 - game.current_turn;
+        for (size_t i = first; i < used; i++) {
+            counts[i].weight = winner < 0 ? 1 : winner == movers[i - first] ? 2 : 0;
+        }
+    }
+    
+    GameRecord record;
+    int imported = 0;
+    while (archive && RecordReaderNext(&reader, &record)) {
+        GameState game = record.start;
+        for (int i = 0, ply = 0; i < record.count && ply < plies; ply++) {
+            Move move;
+            int moved = DecodeMove(record.hops + i, record.count - i, &move);
+            if (!moved || !IsLegalMove(&game, &move)) break;        // Stop at anything illegal
+            counts[used].key = game.key;
+            counts[used].from = move.from;
+            counts[used].to = move.to;
+            counts[used].weight = record.result == 2 ? 1 : record.result == game.current_turn ? 2 : 0;
+            used++;
+            ApplyMove(&game, &move);
+            i += moved;
+        }
+        imported++;
+    }
+    if (archive) RecordReaderClose(&reader);
+    
+    qsort(counts, used, sizeof(BookCount), CompareBookCounts);
+    size_t merged = 0;
+    for (size_t i = 0; i < used; i++) {         // Add up repeats of the same move
+        if (merged > 0 && CompareBookCounts(&counts[merged - 1], &counts[i]) == 0) {
+            counts[merged - 1].weight += counts[i].weight;
+        } else {
+            counts[merged++] = counts[i];
+        }
+    }
+    
+    FILE *file = fopen(filename, "wb");
+    if (!file) {
+        printf("Error: Could not open file '%s' for writing\n", filename);
+        return 0;
+    }
+    BookHeader header = {BOOK_MAGIC, 0, 0};
+    fwrite(&header, sizeof(header), 1, file);
+    for (size_t i = 0; i < merged; i++) {
+        if (counts[i].weight == 0) continue;        // Never worked out, leave it to the search
+        BookEntry entry = {counts[i].key, counts[i].from, counts[i].to,
+                           counts[i].weight > 65535 ? 65535 : counts[i].weight};
+        fwrite(&entry, sizeof(entry), 1, file);
+        header.count++;
+    }
+    fseek(file, 0, SEEK_SET);
+    fwrite(&header, sizeof(header), 1, file);
+    fclose(file);
+    
+    printf("Wrote %llu book moves from %d games to '%s' (%.1f s)\n", (unsigned long long)header.count,
+           games + imported, filename, NowSeconds() - start);
+    free(counts);
+    free(movers);
+    TTFree(&engine.tt);
+    return 1;
+}
+
+// Self-play
+// Headless bot against bot games spread over worker threads. Each worker has its own engine, hash
+// table and RNG, plays a few random plies to open so games differ, then searches every move. Games are
+// packed into a per-worker buffer of game records as they finish and only written out once all of them
+// are done, either straight into a .ckg archive or as text.
+#define SELFPLAY_MAX_PLIES  200         // Drawn after this many
+#define SELFPLAY_MAX_HOPS   2048
+
+typedef struct {
+    int id;
+    uint64_t rng;
+    Engine engine;
+    int random_plies;
+    atomic_int *next_game;
+    int games;
+    uint8_t *buffer;
+    size_t used, capacity;
+    uint64_t plies;
+    int results[3];             // Red wins, black wins, draws
+} SelfPlayWorker;
+
+static int PlaySelfPlayGame(SelfPlayWorker *worker, uint8_t *hops, int *length) {     // Returns 0/1 for the winner, 2 for a draw
+    GameState game;
+    InitializeGame(&game);
+    History history;
+    HistoryStart(&history, &game);
+    worker->engine.history = &history;
+    int ply = 0;
+    *length = 0;
+    
+    while (HasValidMoves(&game, game.current_turn)) {
+        if (IsDrawn(&history, &game) || ply >= SELFPLAY_MAX_PLIES || *length > SELFPLAY_MAX_HOPS - MAX_HOPS) {
+            worker->plies += ply;
+            return 2;
+        }
+        Move move;
+        if (ply < worker->random_plies) {
+            Move moves[MAX_MOVES];
+            int count = GenerateMoves(&game, game.current_turn, moves);
+            move = moves[SplitMix64(&worker->rng) % count];
+        } else {
+            SearchBestMove(&worker->engine, &game, &move);
+        }
+        *length += EncodeMove(&move, hops + *length);
+        ApplyMove(&game, &move);
+        HistoryPush(&history, &game);
+        ply++;
+    }
+    worker->plies += ply;
+    return 1 - game.current_turn;
+}
+
+static void *SelfPlayThread(void *arg) {
+    SelfPlayWorker *worker = arg;
+    uint8_t hops[SELFPLAY_MAX_HOPS];
+    
+    while (atomic_fetch_add(worker->next_game, 1) < worker->games) {
+        int length;
+        int result = PlaySelfPlayGame(worker, hops, &length);
+        worker->results[result]++;
+        
+        if (worker->used + length + RECORD_HEADER_SIZE > worker->capacity) {
+            size_t capacity = worker->capacity * 2 + length + RECORD_HEADER_SIZE;
+            uint8_t *buffer = realloc(worker->buffer, capacity);
+            if (!buffer) break;
+            worker->buffer = buffer;
+            worker->capacity = capacity;
+        }
+        worker->used += EncodeRecordHeader(worker->buffer + worker->used, result, NULL, length);
+        memcpy(worker->buffer + worker->used, hops, length);
+        worker->used += length;
+    }
+    return NULL;
+}
+
+int CheckersSelfPlay(int games, int workers, const SearchLimits *limits, size_t hash_mb, const char *filename,
+                     const CheckersWeights *weights) {
+    if (workers < 1) workers = 1;
+    SelfPlayWorker *pool = calloc(workers, sizeof(SelfPlayWorker));
+    pthread_t *handles = calloc(workers, sizeof(pthread_t));
+    if (!pool || !handles) return 0;
+    atomic_int next_game;
+    atomic_init(&next_game, 0);
+    uint64_t seed = (uint64_t)time(NULL);
+    EvalWeights eval;               // Shared by the workers, read only
+    SetWeights(&eval, weights);
+    
+    for (int i = 0; i < workers; i++) {
+        SelfPlayWorker *worker = &pool[i];
+        worker->id = i;
+        worker->rng = SplitMix64(&seed);
+        worker->engine.limits = *limits;
+        worker->engine.threads = 1;
+        worker->engine.weights = &eval;
+        worker->random_plies = 4;
+        worker->next_game = &next_game;
+        worker->games = games;
+        if (!TTInit(&worker->engine.tt, hash_mb)) {
+            printf("Error: Could not allocate %zu MB hash table\n", hash_mb);
+            return 0;
+        }
+    }
+    
+    double start = NowSeconds();
+    int started = 0;
+    for (int i = 0; i < workers; i++) {
+        if (pthread_create(&handles[i], NULL, SelfPlayThread, &pool[i]) != 0) break;
+        started++;
+    }
+    if (started == 0) SelfPlayThread(&pool[0]);
+    for (int i = 0; i < started; i++) {
+        pthread_join(handles[i], NULL);
+    }
+    double elapsed = NowSeconds() - start;
+    
+    size_t name_length = strlen(filename);
+    int binary = name_length > 4 && strcmp(filename + name_length - 4, ".ckg") == 0;
+    RecordWriter writer;
+    FILE *file = NULL;
+    if (binary ? !RecordWriterOpen(&writer, filename) : !(file = fopen(filename, "w"))) {
+        if (!binary) printf("Error: Could not open file '%s' for writing\n", filename);
+        return 0;
+    }
+    uint64_t plies = 0;
+    int results[3] = {0, 0, 0};
+    for (int i = 0; i < workers; i++) {
+        if (binary) {               // The buffers already are records
+            fwrite(pool[i].buffer, 1, pool[i].used, writer.file);
+        } else {
+            RecordReader reader;
+            GameRecord record;
+            RecordReaderMemory(&reader, pool[i].buffer, pool[i].used);
+            while (RecordReaderNext(&reader, &record)) {
+                PrintRecordMoves(file, &record);
+            }
+        }
+        plies += pool[i].plies;
+        for (int r = 0; r < 3; r++) results[r] += pool[i].results[r];
+        free(pool[i].buffer);
+        TTFree(&pool[i].engine.tt);
+    }
+    if (binary) {
+        RecordWriterClose(&writer);
+    } else {
+        fclose(file);
+    }
+    
+    printf("Games: %d (red %d, black %d, draws %d) on %d threads\n", games, results[0], results[1], results[2], workers);
+    printf("Time: %.3f s\n", elapsed);
+    printf("Games/sec: %.1f\n", elapsed > 0 ? games / elapsed : 0.0);
+    printf("Plies/sec: %.0f\n", elapsed > 0 ? plies / elapsed : 0.0);
+    free(pool);
+    free(handles);
+    return 1;
+}
+
+// Batch analysis
+// Reads positions as the same pieces/kings/turn triple SaveGame writes (or 17 byte binary triples with
+// -binary), searches each one on a pool of worker threads and prints the best move, score, depth and
+// nodes per position in input order. Positions go through in chunks so memory stays flat.
+#define BATCH_CHUNK 4096
+
+typedef struct {
+    GameState game;
+    int valid;
+    Move move;
+    int has_move;
+    int score;
+    int depth;
+    uint64_t nodes;
+} BatchItem;
+
+typedef struct {
+    Engine engine;
+    BatchItem *items;
+    int count;
+    atomic_int *next;
+} BatchWorker;
+
+static void *BatchThread(void *arg) {
+    BatchWorker *worker = arg;
+    int i;
+    while ((i = atomic_fetch_add(worker->next, 1)) < worker->count) {
+        BatchItem *item = &worker->items[i];
+        if (!item->valid) continue;
+        TTClear(&worker->engine.tt);        // Fresh table per position, so results don't depend on the worker count
+        item->has_move = SearchBestMove(&worker->engine, &item->game, &item->move);
+        item->score = worker->engine.score;
+        item->depth = worker->engine.depth;
+        item->nodes = worker->engine.nodes;
+    }
+    return NULL;
+}
+
+static int ReadBatchPosition(FILE *file, int binary, GameState *game) {     // Returns 0 at the end of input
+    if (binary) {
+        uint8_t raw[RECORD_START_SIZE];
+        if (fread(raw, 1, sizeof(raw), file) != sizeof(raw)) return 0;
+        memcpy(&game->pieces, raw, 8);
+        memcpy(&game->kings, raw + 8, 8);
+        game->current_turn = raw[16];
+    } else {
+        unsigned long long pieces, kings;
+        if (fscanf(file, "%llu %llu %d", &pieces, &kings, &game->current_turn) != 3) return 0;
+        game->pieces = pieces;
+        game->kings = kings;
+    }
+    return 1;
+}
+
+static int ValidBatchPosition(GameState *game) {        // Both colors on one square, or a king with no piece, is rejected
+    int valid = (game->current_turn == 0 || game->current_turn == 1) &&
+                !(game->pieces & (game->pieces >> 32)) && !(game->kings & ~game->pieces);
+    ComputeState(game);
+    return valid;
+}
+
+int CheckersAnalyzeEval(const char *filename, int binary, const CheckersWeights *weights) {     // Static evaluation only, index and score per position
+    FILE *file = strcmp(filename, "-") == 0 ? stdin : fopen(filename, binary ? "rb" : "r");
+    if (!file) {
+        printf("Error: Could not open file '%s' for reading\n", filename);
+        return 0;
+    }
+    GameState *games = malloc(BATCH_CHUNK * sizeof(GameState));
+    int *scores = malloc(BATCH_CHUNK * sizeof(int));
+    uint8_t *valid = malloc(BATCH_CHUNK);
+    if (!games || !scores || !valid) return 0;
+    EvalWeights eval;
+    SetWeights(&eval, weights);
+    
+    uint64_t total = 0;
+    double eval_time = 0;
+    for (;;) {
+        int count = 0;
+        while (count < BATCH_CHUNK && ReadBatchPosition(file, binary, &games[count])) {
+            valid[count] = ValidBatchPosition(&games[count]);
+            count++;
+        }
+        if (count == 0) break;
+        
+        double start = NowSeconds();
+        EvaluateBatch(games, count, &eval, scores);
+        eval_time += NowSeconds() - start;
+        for (int i = 0; i < count; i++) {
+            if (valid[i]) {
+                printf("%llu %d\n", (unsigned long long)(total + i), scores[i]);
+            } else {
+                printf("%llu invalid\n", (unsigned long long)(total + i));
+            }
+        }
+        total += count;
+    }
+    fprintf(stderr, "Positions: %llu, evaluation: %.3f s (%s), positions/sec: %.0f\n", (unsigned long long)total,
+            eval_time, eval_kernel_name, eval_time > 0 ? total / eval_time : 0.0);
+    
+    if (file != stdin) fclose(file);
+    free(games);
+    free(scores);
+    free(valid);
+    return 1;
+}
+
+int CheckersAnalyze(const char *filename, int binary, int workers, const SearchLimits *limits,
+                    size_t hash_mb, const char *tablebase, const CheckersWeights *weights) {
+    FILE *file = strcmp(filename, "-") == 0 ? stdin : fopen(filename, binary ? "rb" : "r");
+    if (!file) {
+        printf("Error: Could not open file '%s' for reading\n", filename);
+        return 0;
+    }
+    if (workers < 1) workers = 1;
+    BatchItem *items = malloc(BATCH_CHUNK * sizeof(BatchItem));
+    BatchWorker *pool = calloc(workers, sizeof(BatchWorker));
+    pthread_t *handles = calloc(workers, sizeof(pthread_t));
+    if (!items || !pool || !handles) return 0;
+    atomic_int next;
+    Tablebase tb;
+    if (tablebase && !TBOpen(&tb, tablebase)) {
+        printf("Error: Could not open tablebase '%s'\n", tablebase);
+        return 0;
+    }
+    EvalWeights eval;
+    SetWeights(&eval, weights);
+    
+    for (int i = 0; i < workers; i++) {
+        pool[i].engine.limits = *limits;
+        pool[i].engine.threads = 1;
+        pool[i].engine.weights = &eval;
+        pool[i].engine.tb = tablebase ? &tb : NULL;
+        pool[i].engine.search_forced = 1;
+        pool[i].items = items;
+        pool[i].next = &next;
+        if (!TTInit(&pool[i].engine.tt, hash_mb)) {
+            printf("Error: Could not allocate %zu MB hash table\n", hash_mb);
+            return 0;
+        }
+    }
+    
+    uint64_t total = 0, total_nodes = 0;
+    double start = NowSeconds();
+    for (;;) {
+        int count = 0;
+        while (count < BATCH_CHUNK && ReadBatchPosition(file, binary, &items[count].game)) {
+            items[count].valid = ValidBatchPosition(&items[count].game);
+            count++;
+        }
+        if (count == 0) break;
+        
+        atomic_init(&next, 0);
+        int started = 0;
+        for (int i = 0; i < workers; i++) {
+            pool[i].count = count;
+            if (pthread_create(&handles[i], NULL, BatchThread, &pool[i]) != 0) break;
+            started++;
+        }
+        if (started == 0) BatchThread(&pool[0]);
+        for (int i = 0; i < started; i++) {
+            pthread_join(handles[i], NULL);
+        }
+        
+        for (int i = 0; i < count; i++) {           // index move score depth nodes
+            BatchItem *item = &items[i];
+            if (!item->valid) {
+                printf("%llu invalid\n", (unsigned long long)(total + i));
+                continue;
+            }
+            printf("%llu ", (unsigned long long)(total + i));
+            if (item->has_move) {
+                PrintMove(stdout, &item->move);
+            } else {
+                printf("none");
+            }
+            printf(" %d %d %llu\n", item->score, item->depth, (unsigned long long)item->nodes);
+            total_nodes += item->nodes;
+        }
+        total += count;
+    }
+    double elapsed = NowSeconds() - start;
+    fprintf(stderr, "Positions: %llu, nodes: %llu, time: %.3f s, positions/sec: %.1f\n", (unsigned long long)total,
+            (unsigned long long)total_nodes, elapsed, elapsed > 0 ? total / elapsed : 0.0);
+    
+    if (file != stdin) fclose(file);
+    for (int i = 0; i < workers; i++) {
+        TTFree(&pool[i].engine.tt);
+    }
+    if (tablebase) TBClose(&tb);
+    free(items);
+    free(pool);
+    free(handles);
+    return 1;
+}
+
+// Evaluation tuning
+// Texel tuning: fits the weights so a logistic curve of the evaluation predicts how games ended.
+// Labelled positions come out of .ckg archives as fixed size records (TUNE_MAGIC, then pieces, kings,
+// turn, result per position) and are mapped into memory. Only quiet positions are kept, where the side
+// to move has no capture, since a pending capture makes the static score meaningless. The evaluation
+// is linear in the weights, so every position's features are worked out once, and each iteration is
+// one pass over those: worker threads add up the loss and gradient of their share of the positions
+//   loss = mean (result - sigmoid(k * eval))^2, result 1 red won, 0 black won, 1/2 draw
+// then Adam steps the weights. k is picked first, as the one that fits the starting weights best.
+#define TUNE_MAGIC      0x31504B43U     // "CKP1"
+#define TUNE_SKIP_PLIES 8               // Openings are book or random moves, they say little about the result
+
+typedef struct __attribute__((packed)) {
+    uint64_t pieces;
+    uint64_t kings;
+    uint8_t turn;
+    uint8_t result;             // As in game records: 0 red won, 1 black won, 2 draw
+} TunePosition;
+
+typedef struct {
+    const int8_t *features;     // [position][EVAL_FEATURES], red minus black
+    const uint8_t *results;
+    const TunePosition *positions;
+    uint64_t start, end;
+    const double *weights;
+    double k;
+    int want_gradient;
+    double loss;
+    double gradient[EVAL_FEATURES];
+    uint64_t used;
+} TuneShard;
+
+int CheckersTuneExtract(const char *archive, const char *filename) {        // .ckg games to labelled positions
+    RecordReader reader;
+    if (!RecordReaderOpen(&reader, archive)) return 0;
+    FILE *file = fopen(filename, "wb");
+    if (!file) {
+        printf("Error: Could not open file '%s' for writing\n", filename);
+        RecordReaderClose(&reader);
+        return 0;
+    }
+    uint32_t header[2] = {TUNE_MAGIC, 0};
+    fwrite(header, sizeof(header), 1, file);
+    
+    uint64_t games = 0, positions = 0;
+    GameRecord record;
+    while (RecordReaderNext(&reader, &record)) {
+        GameState game = record.start;
+        for (int i = 0, ply = 0; i < record.count; ply++) {
+            if (ply >= TUNE_SKIP_PLIES && !GetJumpers(&game, game.current_turn)) {
+                TunePosition position = {game.pieces, game.kings, game.current_turn, record.result};
+                fwrite(&position, sizeof(position), 1, file);
+                positions++;
+            }
+            Move move;
+            int used = DecodeMove(record.hops + i, record.count - i, &move);
+            if (!used || !IsLegalMove(&game, &move)) break;     // Keeps what came before a bad hop
+            ApplyMove(&game, &move);
+            i += used;
+        }
+        games++;
+    }
+    RecordReaderClose(&reader);
+    fclose(file);
+    printf("Wrote %llu positions from %llu games to '%s'\n", (unsigned long long)positions,
+           (unsigned long long)games, filename);
+    return 1;
+}
+
+static void *TuneFeaturesThread(void *arg) {        // Fills the shard's features once
+    TuneShard *shard = arg;
+    int8_t *features = (int8_t *)shard->features;
+    uint8_t *results = (uint8_t *)shard->results;
+    for (uint64_t i = shard->start; i < shard->end; i++) {
+        const TunePosition *position = &shard->positions[i];
+        GameState game = {.pieces = position->pieces, .kings = position->kings, .current_turn = position->turn};
+        int values[EVAL_FEATURES];
+        results[i] = position->result;
+        if (position->result > 2 || position->turn > 1 || (game.pieces & (game.pieces >> 32)) || (game.kings & ~game.pieces)) {
+            results[i] = 0xFF;      // Skipped
+            continue;
+        }
+        ComputeState(&game);        // Key, counts and eval as for any other position
+        EvalFeatures(&game, values, 0);
+        for (int f = 0; f < EVAL_FEATURES; f++) {
+            features[i * EVAL_FEATURES + f] = values[f];
+        }
+    }
+    return NULL;
+}
+
+static void *TuneLossThread(void *arg) {
+    TuneShard *shard = arg;
+    double loss = 0, gradient[EVAL_FEATURES] = {0};
+    uint64_t used = 0;
+    for (uint64_t i = shard->start; i < shard->end; i++) {
+        if (shard->results[i] == 0xFF) continue;
+        const int8_t *features = shard->features + i * EVAL_FEATURES;
+        double eval = 0;
+        for (int f = 0; f < EVAL_FEATURES; f++) {
+            eval += shard->weights[f] * features[f];
+        }
+        double predicted = 1 / (1 + exp(-shard->k * eval));
+        double error = predicted - (shard->results[i] == 2 ? 0.5 : shard->results[i] == 0 ? 1.0 : 0.0);
+        loss += error * error;
+        used++;
+        if (!shard->want_gradient) continue;
+        double slope = error * predicted * (1 - predicted);      // d loss / d eval, without the constant 2k
+        for (int f = 0; f < EVAL_FEATURES; f++) {
+            gradient[f] += slope * features[f];
+        }
+    }
+    shard->loss = loss;
+    shard->used = used;
+    memcpy(shard->gradient, gradient, sizeof(gradient));
+    return NULL;
+}
+
+static void RunTuneShards(TuneShard *shards, int workers, void *(*work)(void *)) {
+    pthread_t *handles = calloc(workers, sizeof(pthread_t));
+    int started = 0;
+    for (int i = 0; handles && i < workers; i++) {
+        if (pthread_create(&handles[i], NULL, work, &shards[i]) != 0) break;
+        started++;
+    }
+    for (int i = started; i < workers; i++) {       // Whatever didn't get a thread runs here
+        work(&shards[i]);
+    }
+    for (int i = 0; i < started; i++) {
+        pthread_join(handles[i], NULL);
+    }
+    free(handles);
+}
+
+static double TuneLoss(TuneShard *shards, int workers, const double *weights, double k, double gradient[]) {   // gradient may be NULL
+    double loss = 0;
+    uint64_t used = 0;
+    for (int i = 0; i < workers; i++) {
+        shards[i].weights = weights;
+        shards[i].k = k;
+        shards[i].want_gradient = gradient != NULL;
+    }
+    RunTuneShards(shards, workers, TuneLossThread);
+    for (int f = 0; gradient && f < EVAL_FEATURES; f++) {
+        gradient[f] = 0;
+    }
+    for (int i = 0; i < workers; i++) {
+        loss += shards[i].loss;
+        used += shards[i].used;
+        for (int f = 0; gradient && f < EVAL_FEATURES; f++) {
+            gradient[f] += shards[i].gradient[f];
+        }
+    }
+    for (int f = 0; gradient && used && f < EVAL_FEATURES; f++) {
+        gradient[f] *= 2 * k / used;
+    }
+    return used ? loss / used : 0;
+}
+
+int CheckersTune(const char *positions_file, const char *weights_file, int workers, int iterations,
+                 const CheckersWeights *start_weights) {
+    int fd = open(positions_file, O_RDONLY);
+    struct stat st;
+    if (fd < 0 || fstat(fd, &st) != 0 || st.st_size < 8) {
+        printf("Error: Could not open positions '%s'\n", positions_file);
+        if (fd >= 0) close(fd);
+        return 0;
+    }
+    void *map = mmap(NULL, st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (map == MAP_FAILED || *(const uint32_t *)map != TUNE_MAGIC) {
+        printf("Error: Invalid positions file '%s'\n", positions_file);
+        if (map != MAP_FAILED) munmap(map, st.st_size);
+        return 0;
+    }
+    uint64_t count = (st.st_size - 8) / sizeof(TunePosition);
+    if (workers < 1) workers = 1;
+    int8_t *features = malloc(count * EVAL_FEATURES + 1);
+    uint8_t *results = malloc(count + 1);
+    TuneShard *shards = calloc(workers, sizeof(TuneShard));
+    if (!features || !results || !shards) {
+        printf("Error: Out of memory for %llu positions\n", (unsigned long long)count);
+        munmap(map, st.st_size);
+        return 0;
+    }
+    for (int i = 0; i < workers; i++) {
+        shards[i].features = features;
+        shards[i].results = results;
+        shards[i].positions = (const TunePosition *)((const uint8_t *)map + 8);
+        shards[i].start = count * i / workers;
+        shards[i].end = count * (i + 1) / workers;
+    }
+    
+    double start = NowSeconds();
+    RunTuneShards(shards, workers, TuneFeaturesThread);
+    munmap(map, st.st_size);            // Only the features are needed from here on
+    
+    double weights[EVAL_FEATURES];
+    for (int f = 0; f < EVAL_FEATURES; f++) {
+        weights[f] = start_weights ? start_weights->values[f] : default_values[f];
+    }
+    double low = log(1e-4), high = log(1e-1);       // Golden section search over log k
+    for (int step = 0; step < 30; step++) {
+        double a = high - (high - low) * 0.618, b = low + (high - low) * 0.618;
+        if (TuneLoss(shards, workers, weights, exp(a), NULL) < TuneLoss(shards, workers, weights, exp(b), NULL)) {
+            high = b;
+        } else {
+            low = a;
+        }
+    }
+    double k = exp((low + high) / 2);
+    double first_loss = TuneLoss(shards, workers, weights, k, NULL);
+    printf("Positions: %llu, k = %.6f, loss %.6f\n", (unsigned long long)count, k, first_loss);
+    
+    double m[EVAL_FEATURES] = {0}, v[EVAL_FEATURES] = {0}, gradient[EVAL_FEATURES];
+    double rate = 1.0, beta1 = 0.9, beta2 = 0.999;      // Adam, the rate is in weight units per step
+    double loss = first_loss;
+    for (int iteration = 1; iteration <= iterations; iteration++) {
+        loss = TuneLoss(shards, workers, weights, k, gradient);
+        for (int f = 0; f < EVAL_FEATURES; f++) {
+            m[f] = beta1 * m[f] + (1 - beta1) * gradient[f];
+            v[f] = beta2 * v[f] + (1 - beta2) * gradient[f] * gradient[f];
+            double m_hat = m[f] / (1 - pow(beta1, iteration)), v_hat = v[f] / (1 - pow(beta2, iteration));
+            weights[f] -= rate * m_hat / (sqrt(v_hat) + 1e-12);
+        }
+        if (iteration % 50 == 0) printf("Iteration %d: loss %.6f\n", iteration, loss);
+    }
+    
+    int tuned[EVAL_FEATURES];               // Only written out, the weights in use stay as they are
+    double rounded[EVAL_FEATURES];          // What the file gets, so that's what the final loss is of
+    for (int f = 0; f < EVAL_FEATURES; f++) {
+        tuned[f] = (int)lround(weights[f]);
+        rounded[f] = tuned[f];
+    }
+    double final_loss = TuneLoss(shards, workers, rounded, k, NULL);
+    double elapsed = NowSeconds() - start;
+    free(features);
+    free(results);
+    free(shards);
+    
+    FILE *file = fopen(weights_file, "w");
+    if (!file) {
+        printf("Error: Could not open file '%s' for writing\n", weights_file);
+        return 0;
+    }
+    fprintf(file, "# Texel tuned on %llu positions, loss %.6f -> %.6f\n", (unsigned long long)count, first_loss, final_loss);
+    SaveWeights(file, tuned);
+    fclose(file);
+    SaveWeights(stdout, tuned);
+    printf("Loss: %.6f -> %.6f\n", first_loss, final_loss);
+    printf("Time: %.3f s on %d threads\n", elapsed, workers);
+    printf("Positions/sec: %.0f\n", elapsed > 0 ? (double)count * (iterations + 60) / elapsed : 0.0);     // Every loss pass, k search included
+    return 1;
+}
+
+// Perft
+uint64_t Perft(GameState *game, int depth) {       // Counts the leaves of the legal move tree
+    if (depth == 0) return 1;
+    
+    Move moves[MAX_MOVES];
+    int count = GenerateMoves(game, game->current_turn, moves);
+    if (depth == 1) return count;       // Every move is a whole turn, so the last ply is just a count
+    
+    uint64_t nodes = 0;
+    for (int i = 0; i < count; i++) {
+        MoveDelta delta;
+        GetMoveDelta(game, &moves[i], &delta, &default_weights);
+        MakeDelta(game, &delta);
+        nodes += Perft(game, depth - 1);
+        UnmakeDelta(game, &delta);
+    }
+    return nodes;
+}
+
+
+// Library API
+// What checkers.h exports, everything above stays inside the library. Positions belong to the caller
+// and calls that only look at one work on a copy, so the only shared state is the tables CheckersInit
+// fills once. Each engine carries its own hash table, tablebase mapping, book and RNG.
+struct CheckersEngine {
+    Engine engine;
+    History history;            // engine.history points here once set
+    EvalWeights weights;        // engine.weights points here once set
+    Tablebase tablebase;
+    OpeningBook book;
+    uint64_t rng;               // Picks between book moves
+};
+
+static pthread_once_t init_once = PTHREAD_ONCE_INIT;
+
+static void InitTables(void) {
+    InitZobrist();
+    InitWeights(&default_weights, default_values);
+    InitEvalKernel();
+    TBInitChoose();
+}
+
+void CheckersInit(void) {
+    pthread_once(&init_once, InitTables);
+}
+
+void CheckersNewGame(CheckersGame *game) {
+    InitializeGame(game);
+}
+
+int CheckersSetPosition(CheckersGame *game, uint64_t pieces, uint64_t kings, int turn) {
+    if ((turn != 0 && turn != 1) || (pieces & (pieces >> 32)) || (kings & ~pieces)) return 0;     // Both colors on one square, or a king with no piece
+    game->pieces = pieces;
+    game->kings = kings;
+    game->current_turn = turn;
+    ComputeState(game);
+    return 1;
+}
+
+int CheckersLegalMoves(const CheckersGame *game, CheckersMove moves[CHECKERS_MAX_MOVES]) {
+    GameState position = *game;
+    const MoveCache *legal = LegalMoves(&position);
+    memcpy(moves, legal->moves, legal->count * sizeof(Move));
+    return legal->count;
+}
+
+int CheckersIsLegal(const CheckersGame *game, const CheckersMove *move) {
+    GameState position = *game;
+    return IsLegalMove(&position, move);
+}
+
+int CheckersMustCapture(const CheckersGame *game) {
+    GameState position = *game;
+    const MoveCache *legal = LegalMoves(&position);
+    return legal->count > 0 && legal->moves[0].captures != 0;       // Only captures are generated when there's one
+}
+
+int CheckersApply(CheckersGame *game, const CheckersMove *move, CheckersUndo *undo) {
+    const MoveCache *legal = LegalMoves(game);
+    const Move *moves = legal->moves;
+    for (int i = 0; i < legal->count; i++) {
+        if (!SameMove(&moves[i], move)) continue;
+        MoveDelta delta;            // From the generated move, so a caller's captures field can't throw it off
+        GetMoveDelta(game, &moves[i], &delta, &default_weights);
+        MakeDelta(game, &delta);
+        if (undo) *undo = delta;
+        return delta.flags;
+    }
+    return -1;
+}
+
+void CheckersUndoMove(CheckersGame *game, const CheckersUndo *undo) {
+    UnmakeDelta(game, undo);
+}
+
+int CheckersStatus(const CheckersGame *game, const CheckersHistory *history) {
+    GameState position = *game;
+    if (LegalMoves(&position)->count == 0) return position.current_turn == 0 ? CHECKERS_BLACK_WON : CHECKERS_RED_WON;
+    return IsDrawn(history, &position) ? CHECKERS_DRAW : CHECKERS_PLAYING;
+}
+
+void CheckersHistoryStart(CheckersHistory *history, const CheckersGame *game) {
+    HistoryStart(history, game);
+}
+
+void CheckersHistoryPush(CheckersHistory *history, const CheckersGame *game) {
+    HistoryPush(history, game);
+}
+
+void CheckersHistoryPop(CheckersHistory *history) {
+    HistoryPop(history);
+}
+
+int CheckersEvaluate(const CheckersGame *game, const CheckersWeights *weights) {
+    GameState position = *game;
+    if (!weights) return Evaluate(&position, &default_weights);
+    EvalWeights eval;
+    SetWeights(&eval, weights);
+    position.eval = MaterialEval(&position, &eval);
+    return Evaluate(&position, &eval);
+}
+
+uint64_t CheckersPerft(const CheckersGame *game, int depth) {
+    GameState position = *game;
+    return Perft(&position, depth);
+}
+
+int CheckersSquareAt(int row, int col) {
+    return IsValidPosition(row, col) ? board_square[row][col] : -1;
+}
+
+void CheckersSquareName(int square, char name[3]) {
+    SquareName(square, name);
+}
+
+int CheckersParseSquares(const char *text, int squares[], int max) {     // "c3 e5 c7", "c3-d4" or "c3xe5xc7"
+    int count = 0;
+    for (const char *p = text; *p;) {
+        if (isspace((unsigned char)*p) || *p == '-' || *p == 'x') {
+            p++;
+            continue;
+        }
+        if (count == max || !p[1]) return 0;
+        int col = tolower(p[0]) - 'a';
+        int row = 8 - (p[1] - '0');
+        if (!IsValidPosition(row, col)) return 0;
+        squares[count++] = board_to_bitpos(row, col);
+        p += 2;
+    }
+    return count;
+}
+
+int CheckersFindMove(const CheckersGame *game, const int squares[], int count, CheckersMove *move) {
+    GameState position = *game;
+    return FindMove(&position, squares, count, move);
+}
+
+int CheckersParseMove(const CheckersGame *game, const char *text, CheckersMove *move) {
+    int squares[MAX_HOPS + 1];
+    int count = CheckersParseSquares(text, squares, MAX_HOPS + 1);
+    return count >= 2 && CheckersFindMove(game, squares, count, move) == 2;
+}
+
+int CheckersFormatMove(const CheckersMove *move, char text[CHECKERS_MOVE_TEXT]) {
+    return FormatMove(move, text);
+}
+
+size_t CheckersSerialize(const CheckersGame *game, uint8_t *buffer, size_t size) {     // Same layout as analyze -binary
+    if (size < CHECKERS_POSITION_BYTES) return 0;
+    memcpy(buffer, &game->pieces, 8);
+    memcpy(buffer + 8, &game->kings, 8);
+    buffer[16] = game->current_turn;
+    return CHECKERS_POSITION_BYTES;
+}
+
+size_t CheckersDeserialize(CheckersGame *game, const uint8_t *buffer, size_t size) {
+    uint64_t pieces, kings;
+    if (size < CHECKERS_POSITION_BYTES) return 0;
+    memcpy(&pieces, buffer, 8);
+    memcpy(&kings, buffer + 8, 8);
+    return CheckersSetPosition(game, pieces, kings, buffer[16]) ? CHECKERS_POSITION_BYTES : 0;
+}
+
+size_t CheckersEncodeMove(const CheckersMove *move, uint8_t *buffer, size_t size) {
+    if (size < (size_t)move->hops) return 0;
+    return EncodeMove(move, buffer);
+}
+
+size_t CheckersDecodeMove(const CheckersGame *game, const uint8_t *buffer, size_t size, CheckersMove *move) {
+    int used = DecodeMove(buffer, size < MAX_HOPS ? (int)size : MAX_HOPS, move);
+    return used && CheckersIsLegal(game, move) ? used : 0;
+}
+
+CheckersEngine *CheckersEngineNew(size_t hash_mb, int threads) {
+    CheckersEngine *engine = calloc(1, sizeof(CheckersEngine));
+    if (!engine) return NULL;
+    if (!TTInit(&engine->engine.tt, hash_mb)) {
+        free(engine);
+        return NULL;
+    }
+    engine->engine.limits.time_ms = 1000;      // 1 second per move until told otherwise
+    engine->engine.threads = threads;
+    atomic_init(&engine->engine.stop, 0);
+    return engine;
+}
+
+void CheckersEngineFree(CheckersEngine *engine) {
+    if (!engine) return;
+    TTFree(&engine->engine.tt);
+    if (engine->engine.tb) TBClose(engine->engine.tb);
+    if (engine->book.map) BookClose(&engine->book);
+    free(engine);
+}
+
+int CheckersEngineSetHash(CheckersEngine *engine, size_t hash_mb) {      // Keeps the old table if the new one won't fit
+    TranspositionTable tt;
+    if (!TTInit(&tt, hash_mb)) return 0;
+    TTFree(&engine->engine.tt);
+    engine->engine.tt = tt;
+    return 1;
+}
+
+void CheckersEngineSetThreads(CheckersEngine *engine, int threads) {
+    engine->engine.threads = threads;
+}
+
+void CheckersEngineSetLimits(CheckersEngine *engine, const CheckersLimits *limits) {
+    engine->engine.limits = *limits;
+}
+
+void CheckersEngineSetMcts(CheckersEngine *engine, int enabled) {
+    if (engine->engine.mcts != enabled) TTClear(&engine->engine.tt);       // The tree and the table share memory
+    engine->engine.mcts = enabled;
+}
+
+void CheckersEngineSetWeights(CheckersEngine *engine, const CheckersWeights *weights) {
+    SetWeights(&engine->weights, weights);
+    engine->engine.weights = weights ? &engine->weights : NULL;
+    TTClear(&engine->engine.tt);        // Its scores were made with the old weights
+}
+
+void CheckersEngineSetHistory(CheckersEngine *engine, const CheckersHistory *history) {
+    if (history) engine->history = *history;
+    engine->engine.history = history ? &engine->history : NULL;
+}
+
+void CheckersEngineSetInfo(CheckersEngine *engine, CheckersInfoCallback callback, void *user) {
+    engine->engine.info = callback;
+    engine->engine.info_user = user;
+}
+
+int CheckersEngineLoadTablebase(CheckersEngine *engine, const char *filename) {
+    Tablebase tb;
+    if (!TBOpen(&tb, filename)) return 0;
+    if (engine->engine.tb) TBClose(engine->engine.tb);
+    engine->tablebase = tb;
+    engine->engine.tb = &engine->tablebase;
+    return 1;
+}
+
+int CheckersEngineLoadBook(CheckersEngine *engine, const char *filename, uint64_t seed) {
+    OpeningBook book;
+    if (!BookOpen(&book, filename)) return 0;
+    if (engine->book.map) BookClose(&engine->book);
+    engine->book = book;
+    engine->rng = seed;
+    return 1;
+}
+
+void CheckersEngineContinue(CheckersEngine *engine) {
+    engine->engine.continuing = 1;
+}
+
+void CheckersEngineClear(CheckersEngine *engine) {
+    TTClear(&engine->engine.tt);
+}
+
+int CheckersSearch(CheckersEngine *engine, const CheckersGame *game, CheckersMove *best, CheckersSearchInfo *result) {
+    GameState position = *game;
+    double start = NowSeconds();
+    int book = engine->book.count && BookProbe(&engine->book, &position, &engine->rng, best);     // Book moves skip the search
+    int found = book || (engine->engine.mcts ? MctsBestMove : SearchBestMove)(&engine->engine, &position, best);
+    engine->engine.continuing = 0;
+#ifndef CHECKERS_NO_STATS
+    if (book) memset(&engine->engine.stats, 0, sizeof(engine->engine.stats));
+#endif
+    if (result) {
+        result->depth = book ? 0 : engine->engine.depth;
+        result->score = book ? 0 : engine->engine.score;
+        result->plies_to_end = book ? 0 : PliesToEnd(engine->engine.score);
+        result->nodes = book ? 0 : engine->engine.nodes;
+        result->seconds = NowSeconds() - start;
+        result->book = book;
+        if (found) result->best = *best;
+    }
+    return found;
+}
+
+void CheckersDefaultWeights(CheckersWeights *weights) {
+    memcpy(weights->values, default_values, sizeof(weights->values));
+}
+
+int CheckersLoadWeights(const char *filename, CheckersWeights *weights) {
+    return LoadWeights(filename, weights->values);
+}
+
+int CheckersEngineStats(const CheckersEngine *engine, CheckersStats *stats) {
+#ifndef CHECKERS_NO_STATS
+    *stats = engine->engine.stats;
+    return 1;
+#else
+    memset(stats, 0, sizeof(*stats));
+    return 0;
+#endif
+}
+
+void CheckersEngineStop(CheckersEngine *engine, int stop) {
+    atomic_store(&engine->engine.stop, stop);
+}
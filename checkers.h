@@ -0,0 +1,198 @@
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+//
+//      libcheckers: the bitboard checkers engine as a library. Positions,
+//      moves and undo records live in caller memory and nothing here prints,
+//      so many games can be played and searched at once in one process.
+//
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+
+#ifndef CHECKERS_H
+#define CHECKERS_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#if defined(__GNUC__)
+#define CHECKERS_API __attribute__((visibility("default")))
+#else
+#define CHECKERS_API
+#endif
+
+#define CHECKERS_MAX_HOPS       12              // A jump sequence can't take more than every opposing piece
+#define CHECKERS_MAX_MOVES      (12 * 12)
+#define CHECKERS_MOVE_TEXT      40              // "e3xg5xe7..." with every hop, plus the terminator
+#define CHECKERS_POSITION_BYTES 17              // pieces, kings as little endian 64 bit, then the turn byte
+#define CHECKERS_MOVE_RULE      80              // Plies with no capture and no man moving before it's a draw, 40 moves each
+#define CHECKERS_HISTORY        (CHECKERS_MOVE_RULE + 1)      // Positions further back can't come up again
+#define CHECKERS_EVAL_FEATURES  7
+
+// Red (player 0) is the low 32 bits of pieces and kings, black the high 32 (bit = row * 4 + col / 2,
+// row 0 at the top, even rows start on column b). The fields after current_turn are kept up to date by
+// the library, so set positions with CheckersNewGame or CheckersSetPosition rather than by hand.
+typedef struct {
+    uint64_t pieces;
+    uint64_t kings;
+    int current_turn;
+    uint64_t key;               // Zobrist hash of the three fields above
+    uint8_t material[2][2];     // [player][men, kings] counts
+    int eval;                   // Sum of the default piece weights from red's side
+    int reversible;             // Plies since the last capture or man move, for the move rule
+} CheckersGame;
+
+typedef struct {                // A whole turn, every hop of a jump sequence included
+    int from_row, from_col;
+    int to_row, to_col;         // Final landing square
+    int capture_row, capture_col;       // First piece jumped, -1 for a quiet move
+    int from, to;               // Same squares as bit positions (0-31)
+    uint32_t captures;          // Every square jumped, as bits of the opponent's half
+    int hops;
+    uint8_t path[CHECKERS_MAX_HOPS];    // Landing square of each hop, path[hops - 1] == to
+} CheckersMove;
+
+#define CHECKERS_CAPTURED   1   // Flags returned by CheckersApply
+#define CHECKERS_KINGED     2
+
+typedef struct {                // Everything a move changes, filled by CheckersApply to take it back
+    uint64_t pieces;            // Bits to xor into the boards
+    uint64_t kings;
+    uint64_t key;
+    int eval;
+    int8_t material[2][2];
+    int reversible;
+    int flags;                  // CHECKERS_CAPTURED / CHECKERS_KINGED
+} CheckersUndo;
+
+enum { CHECKERS_PLAYING, CHECKERS_RED_WON, CHECKERS_BLACK_WON, CHECKERS_DRAW };
+
+typedef struct {                // Keys of the last positions of a game, for draws by repetition
+    int count;                  // Keys held, at most CHECKERS_HISTORY
+    int last;                   // Index of the newest key, older ones wrap around behind it
+    uint64_t keys[CHECKERS_HISTORY];
+} CheckersHistory;
+
+typedef struct {                // Evaluation weights: men, kings, advance, back_rank, centre, mobility, runaway
+    int values[CHECKERS_EVAL_FEATURES];
+} CheckersWeights;
+
+typedef struct {
+    int time_ms;                // Wall clock budget per move, 0 for none
+    int max_depth;              // 0 for none
+    uint64_t max_nodes;         // 0 for none
+} CheckersLimits;
+
+typedef struct {                // One finished depth, or the whole search once it returns
+    int depth;
+    int score;                  // For the side to move, 100 is about a man
+    int plies_to_end;           // A forced win (score > 0) or loss this many plies away, 0 if none was found
+    uint64_t nodes;
+    double seconds;
+    int book;                   // The move came from the opening book, nothing was searched
+    CheckersMove best;
+} CheckersSearchInfo;
+
+#define CHECKERS_MAX_ITERATIONS 64
+
+typedef struct {                // Counters for one search, all threads added up. Built without them with -DCHECKERS_NO_STATS
+    uint64_t nodes;
+    uint64_t movegen_calls;
+    uint64_t moves_generated;
+    uint64_t captures_generated;        // Moves of the above that were captures
+    uint64_t tt_probes;
+    uint64_t tt_hits;
+    uint64_t tt_cutoffs;                // Hits that ended the node
+    uint64_t tt_collisions;             // Hits whose move isn't legal here, so another position's entry
+    uint64_t expanded;                  // Nodes that went through their moves
+    uint64_t moves_searched;            // Over expanded nodes, the branching factor
+    uint64_t cutoffs;
+    uint64_t first_move_cutoffs;        // Over cutoffs, how good the move ordering is
+    uint64_t playouts;                  // Tree search only (CheckersEngineSetMcts), nodes is the same count
+    uint64_t tree_nodes;                // Arena nodes it used
+    double seconds;
+    int iterations;                     // Depths the main thread finished
+    double iteration_seconds[CHECKERS_MAX_ITERATIONS];     // Per depth, main thread
+    uint64_t iteration_nodes[CHECKERS_MAX_ITERATIONS];
+} CheckersStats;
+
+typedef void (*CheckersInfoCallback)(const CheckersSearchInfo *info, void *user);
+
+typedef struct CheckersEngine CheckersEngine;   // Hash table, search settings, tablebase and book
+
+// Setup. CheckersInit fills the shared tables, call it before anything else (more calls do nothing).
+CHECKERS_API void CheckersInit(void);
+CHECKERS_API void CheckersDefaultWeights(CheckersWeights *weights);
+CHECKERS_API int CheckersLoadWeights(const char *filename, CheckersWeights *weights);    // From CheckersTune, names not in the file keep their value
+CHECKERS_API void CheckersNewGame(CheckersGame *game);
+CHECKERS_API int CheckersSetPosition(CheckersGame *game, uint64_t pieces, uint64_t kings, int turn);  // 0 if it can't happen
+
+// Moves
+CHECKERS_API int CheckersLegalMoves(const CheckersGame *game, CheckersMove moves[CHECKERS_MAX_MOVES]);
+CHECKERS_API int CheckersIsLegal(const CheckersGame *game, const CheckersMove *move);
+CHECKERS_API int CheckersMustCapture(const CheckersGame *game);
+CHECKERS_API int CheckersApply(CheckersGame *game, const CheckersMove *move, CheckersUndo *undo);     // Flags, -1 if illegal. undo may be NULL
+CHECKERS_API void CheckersUndoMove(CheckersGame *game, const CheckersUndo *undo);
+CHECKERS_API int CheckersStatus(const CheckersGame *game, const CheckersHistory *history);    // No move loses. history may be NULL
+CHECKERS_API int CheckersEvaluate(const CheckersGame *game, const CheckersWeights *weights);    // Static score for the side to move. weights may be NULL
+CHECKERS_API uint64_t CheckersPerft(const CheckersGame *game, int depth);
+
+// Game history. Start it at the first position and push every position played, then CheckersStatus
+// calls a position seen for the third time a draw, and a search given it avoids or aims for repeats.
+CHECKERS_API void CheckersHistoryStart(CheckersHistory *history, const CheckersGame *game);
+CHECKERS_API void CheckersHistoryPush(CheckersHistory *history, const CheckersGame *game);   // After every move
+CHECKERS_API void CheckersHistoryPop(CheckersHistory *history);         // After CheckersUndoMove
+
+// Text. Squares are "c3", moves "c3-d4" or "e3xg5xe7".
+CHECKERS_API int CheckersSquareAt(int row, int col);               // Bit position, -1 off the board or on a light square
+CHECKERS_API void CheckersSquareName(int square, char name[3]);
+CHECKERS_API int CheckersParseSquares(const char *text, int squares[], int max);       // Count, 0 if one isn't on the board
+CHECKERS_API int CheckersFindMove(const CheckersGame *game, const int squares[], int count, CheckersMove *move);  // 2 whole move, 1 start of a jump sequence, 0 none
+CHECKERS_API int CheckersParseMove(const CheckersGame *game, const char *text, CheckersMove *move);     // 1 for a whole legal move
+CHECKERS_API int CheckersFormatMove(const CheckersMove *move, char text[CHECKERS_MOVE_TEXT]);
+
+// Serialization into caller buffers, both return the bytes used and 0 when it doesn't fit or is invalid
+CHECKERS_API size_t CheckersSerialize(const CheckersGame *game, uint8_t *buffer, size_t size);
+CHECKERS_API size_t CheckersDeserialize(CheckersGame *game, const uint8_t *buffer, size_t size);
+CHECKERS_API size_t CheckersEncodeMove(const CheckersMove *move, uint8_t *buffer, size_t size);       // One byte per hop, as in .ckg records
+CHECKERS_API size_t CheckersDecodeMove(const CheckersGame *game, const uint8_t *buffer, size_t size, CheckersMove *move);
+
+// Engines. One per game being searched at a time; different engines never share anything writable.
+CHECKERS_API CheckersEngine *CheckersEngineNew(size_t hash_mb, int threads);       // NULL if the table can't be allocated
+CHECKERS_API void CheckersEngineFree(CheckersEngine *engine);
+CHECKERS_API int CheckersEngineSetHash(CheckersEngine *engine, size_t hash_mb);
+CHECKERS_API void CheckersEngineSetThreads(CheckersEngine *engine, int threads);
+CHECKERS_API void CheckersEngineSetLimits(CheckersEngine *engine, const CheckersLimits *limits);
+CHECKERS_API void CheckersEngineSetMcts(CheckersEngine *engine, int enabled);     // Monte Carlo tree search: max_nodes counts playouts, scores run -1000 to 1000
+CHECKERS_API void CheckersEngineSetWeights(CheckersEngine *engine, const CheckersWeights *weights);     // Copied, NULL for the defaults
+CHECKERS_API void CheckersEngineSetHistory(CheckersEngine *engine, const CheckersHistory *history);     // Copied, NULL for none
+CHECKERS_API void CheckersEngineSetInfo(CheckersEngine *engine, CheckersInfoCallback callback, void *user);  // Called per finished depth
+CHECKERS_API int CheckersEngineLoadTablebase(CheckersEngine *engine, const char *filename);
+CHECKERS_API int CheckersEngineLoadBook(CheckersEngine *engine, const char *filename, uint64_t seed);
+CHECKERS_API void CheckersEngineClear(CheckersEngine *engine);      // Forget the hash table, for a new game
+CHECKERS_API void CheckersEngineContinue(CheckersEngine *engine);   // Next search only: it follows on from the last one (a ponder), don't age its entries
+CHECKERS_API int CheckersSearch(CheckersEngine *engine, const CheckersGame *game, CheckersMove *best, CheckersSearchInfo *result);  // 0 if no move
+CHECKERS_API int CheckersEngineStats(const CheckersEngine *engine, CheckersStats *stats);    // Last search, 0 if built without stats
+CHECKERS_API void CheckersEngineStop(CheckersEngine *engine, int stop);     // Any thread. Stays set, searches return at once until cleared
+
+// Command line tools. Unlike the calls above these write files and print their results to stdout.
+// The ones that search or evaluate take the weights to do it with, NULL for the defaults.
+CHECKERS_API int CheckersTBGenerate(int max_pieces, const char *filename);
+CHECKERS_API int CheckersBookBuild(int games, int plies, const char *archive, const char *filename,
+                                   const CheckersWeights *weights);     // archive may be NULL
+CHECKERS_API int CheckersSelfPlay(int games, int workers, const CheckersLimits *limits, size_t hash_mb, const char *filename,
+                                  const CheckersWeights *weights);
+CHECKERS_API int CheckersAnalyze(const char *filename, int binary, int workers, const CheckersLimits *limits,
+                                 size_t hash_mb, const char *tablebase, const CheckersWeights *weights);      // tablebase may be NULL
+CHECKERS_API int CheckersAnalyzeEval(const char *filename, int binary, const CheckersWeights *weights);
+CHECKERS_API int CheckersReplay(const char *filename);
+CHECKERS_API int CheckersTuneExtract(const char *archive, const char *filename);      // Labelled positions from a .ckg archive
+CHECKERS_API int CheckersTune(const char *positions, const char *weights, int workers, int iterations,
+                              const CheckersWeights *start);          // Fits from start, writes the result to weights
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,285 @@
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+//
+//      Load generator for checkers-server: plays random moves in many games
+//      at once over a few connections and reports how long the bot took to
+//      answer each one, as seen from the client.
+//
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <time.h>
+#include <unistd.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <arpa/inet.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <sys/epoll.h>
+#include "checkers.h"
+
+#define LINE_MAX_LENGTH 256
+
+typedef struct {                // One game played against the server
+    CheckersGame game;
+    int connection;
+    int id;                     // Server's id, -1 until the game reply
+    double sent;                // When the move went out
+    double wake;                // Thinking until then
+    int next_waiting;           // Queue of games thinking, -1 ends it
+} Player;
+
+typedef struct {
+    int fd;
+    char in[LINE_MAX_LENGTH];
+    int in_used;
+    int *pending;               // Players whose new hasn't been answered, in order
+    int pending_head, pending_tail, pending_size;
+} Link;
+
+Player *players;
+Link *links;
+int *player_by_id;              // Server ids to players
+int id_capacity;
+int think_ms;                   // Pause before each move
+int time_ms;                    // Budget sent with each move, 0 for the server default
+uint64_t rng = 0x9E3779B97F4A7C15ULL;
+int waiting_head = -1, waiting_tail = -1;       // Fixed think time, so wake times come in order
+double *latencies;
+long latency_count, latency_target;
+long games_finished, errors;
+
+static double NowSeconds() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static uint64_t NextRandom() {          // xorshift64
+    rng ^= rng << 13;
+    rng ^= rng >> 7;
+    rng ^= rng << 17;
+    return rng;
+}
+
+static void Send(Link *link, const char *text) {       // Blocking, the server always reads
+    size_t length = strlen(text), sent = 0;
+    while (sent < length) {
+        ssize_t n = send(link->fd, text + sent, length - sent, MSG_NOSIGNAL);
+        if (n <= 0) {
+            if (errno == EINTR) continue;
+            printf("Error: Lost the server: %s\n", strerror(errno));
+            exit(1);
+        }
+        sent += n;
+    }
+}
+
+static void StartGame(int index) {
+    Player *player = &players[index];
+    Link *link = &links[player->connection];
+    CheckersNewGame(&player->game);
+    player->id = -1;
+    link->pending[link->pending_tail++ % link->pending_size] = index;
+    Send(link, "new\n");
+}
+
+static void Think(int index) {          // Queues the next move after the think time
+    Player *player = &players[index];
+    player->wake = NowSeconds() + think_ms / 1000.0;
+    player->next_waiting = -1;
+    if (waiting_tail >= 0) {
+        players[waiting_tail].next_waiting = index;
+    } else {
+        waiting_head = index;
+    }
+    waiting_tail = index;
+}
+
+static void PlayMove(int index) {
+    Player *player = &players[index];
+    CheckersMove moves[CHECKERS_MAX_MOVES];
+    int count = CheckersLegalMoves(&player->game, moves);
+    CheckersMove *move = &moves[NextRandom() % count];     // The server says when a game is over, so there's one
+    char text[CHECKERS_MOVE_TEXT], line[LINE_MAX_LENGTH];
+    CheckersFormatMove(move, text);
+    CheckersApply(&player->game, move, NULL);
+    snprintf(line, sizeof(line), "move %d %s %d\n", player->id, text, time_ms);
+    player->sent = NowSeconds();
+    Send(&links[player->connection], line);
+}
+
+static void EndGame(int index) {
+    char line[LINE_MAX_LENGTH];
+    snprintf(line, sizeof(line), "end %d\n", players[index].id);
+    Send(&links[players[index].connection], line);
+    player_by_id[players[index].id] = -1;
+    games_finished++;
+    StartGame(index);
+}
+
+static int PlayerFor(const char *id_text) {
+    int id = id_text ? atoi(id_text) : -1;
+    return id >= 0 && id < id_capacity ? player_by_id[id] : -1;
+}
+
+static void HandleLine(Link *link, char *line) {
+    char *kind = strtok(line, " ");
+    char *id_text = strtok(NULL, " ");
+    if (!kind) return;
+    if (strcmp(kind, "game") == 0 && id_text && link->pending_head < link->pending_tail) {
+        int index = link->pending[link->pending_head++ % link->pending_size];
+        int id = atoi(id_text);
+        if (id >= id_capacity) {
+            int capacity = id_capacity * 2 > id ? id_capacity * 2 : id + 1;
+            player_by_id = realloc(player_by_id, capacity * sizeof(int));
+            if (!player_by_id) exit(1);
+            for (int i = id_capacity; i < capacity; i++) player_by_id[i] = -1;
+            id_capacity = capacity;
+        }
+        player_by_id[id] = index;
+        players[index].id = id;
+        Think(index);
+    } else if (strcmp(kind, "bot") == 0 && PlayerFor(id_text) >= 0) {
+        int index = PlayerFor(id_text);
+        char *text = strtok(NULL, " "), *state = strtok(NULL, " ");
+        if (latency_count < latency_target) latencies[latency_count++] = NowSeconds() - players[index].sent;
+        CheckersMove move;
+        if (text && CheckersParseMove(&players[index].game, text, &move)) CheckersApply(&players[index].game, &move, NULL);
+        if (!state || strcmp(state, "playing") != 0) {
+            EndGame(index);
+        } else {
+            Think(index);
+        }
+    } else if (strcmp(kind, "over") == 0 && PlayerFor(id_text) >= 0) {
+        EndGame(PlayerFor(id_text));
+    } else if (strcmp(kind, "ended") != 0) {
+        errors++;
+        if (errors <= 5) printf("Unexpected reply: %s %s\n", kind, id_text ? id_text : "");
+    }
+}
+
+static int Connect(int port, const char *unix_path) {
+    int fd;
+    if (unix_path) {
+        struct sockaddr_un address = {.sun_family = AF_UNIX};
+        strncpy(address.sun_path, unix_path, sizeof(address.sun_path) - 1);
+        fd = socket(AF_UNIX, SOCK_STREAM, 0);
+        if (fd < 0 || connect(fd, (struct sockaddr *)&address, sizeof(address)) != 0) return -1;
+    } else {
+        struct sockaddr_in address = {.sin_family = AF_INET, .sin_port = htons(port)};
+        address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        fd = socket(AF_INET, SOCK_STREAM, 0);
+        if (fd < 0 || connect(fd, (struct sockaddr *)&address, sizeof(address)) != 0) return -1;
+        int on = 1;
+        setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &on, sizeof(on));
+    }
+    return fd;
+}
+
+static int CompareDoubles(const void *a, const void *b) {
+    double x = *(const double *)a, y = *(const double *)b;
+    return (x > y) - (x < y);
+}
+
+int main(int argc, char *argv[]) {
+    CheckersInit();
+    int port = 7000, sessions = 10000, connections = 100;
+    const char *unix_path = NULL;
+    latency_target = 100000;
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "-port") == 0 && i + 1 < argc) {
+            port = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "-unix") == 0 && i + 1 < argc) {
+            unix_path = argv[++i];
+        } else if (strcmp(argv[i], "-sessions") == 0 && i + 1 < argc) {       // Games going at once
+            sessions = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "-connections") == 0 && i + 1 < argc) {    // Games are spread over these
+            connections = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "-moves") == 0 && i + 1 < argc) {          // Bot replies to time before stopping
+            latency_target = atol(argv[++i]);
+        } else if (strcmp(argv[i], "-think") == 0 && i + 1 < argc) {          // Player's pause before each move
+            think_ms = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "-time") == 0 && i + 1 < argc) {           // Bot budget asked for per move
+            time_ms = atoi(argv[++i]);
+        } else {
+            printf("Usage: checkers-load [-port n | -unix path] [-sessions n] [-connections n] [-moves n] [-think ms] [-time ms]\n");
+            return 1;
+        }
+    }
+    if (sessions < 1) sessions = 1;
+    if (connections < 1) connections = 1;
+    if (connections > sessions) connections = sessions;
+
+    players = calloc(sessions, sizeof(Player));
+    links = calloc(connections, sizeof(Link));
+    latencies = malloc(latency_target * sizeof(double));
+    int epoll_fd = epoll_create1(0);
+    if (!players || !links || !latencies || epoll_fd < 0) return 1;
+    for (int i = 0; i < connections; i++) {
+        links[i].fd = Connect(port, unix_path);
+        links[i].pending_size = sessions / connections + 1;
+        links[i].pending = malloc(links[i].pending_size * sizeof(int));
+        struct epoll_event event = {.events = EPOLLIN, .data.ptr = &links[i]};
+        if (links[i].fd < 0 || !links[i].pending || epoll_ctl(epoll_fd, EPOLL_CTL_ADD, links[i].fd, &event) != 0) {
+            printf("Error: Could not connect: %s\n", strerror(errno));
+            return 1;
+        }
+    }
+
+    double start = NowSeconds();
+    for (int i = 0; i < sessions; i++) {
+        players[i].connection = i % connections;
+        StartGame(i);
+    }
+
+    struct epoll_event events[256];
+    char buffer[16384];
+    while (latency_count < latency_target) {
+        double now = NowSeconds();
+        while (waiting_head >= 0 && players[waiting_head].wake <= now) {        // Done thinking
+            int index = waiting_head;
+            waiting_head = players[index].next_waiting;
+            if (waiting_head < 0) waiting_tail = -1;
+            PlayMove(index);
+        }
+        int timeout = waiting_head < 0 ? 1000 : (int)((players[waiting_head].wake - now) * 1000) + 1;
+        int count = epoll_wait(epoll_fd, events, 256, timeout);
+        for (int i = 0; i < count; i++) {
+            Link *link = events[i].data.ptr;
+            ssize_t got = recv(link->fd, buffer, sizeof(buffer), 0);
+            if (got <= 0) {
+                printf("Error: The server closed the connection\n");
+                return 1;
+            }
+            for (ssize_t j = 0; j < got; j++) {
+                if (buffer[j] == '\n') {
+                    link->in[link->in_used] = '\0';
+                    HandleLine(link, link->in);
+                    link->in_used = 0;
+                } else if (link->in_used < LINE_MAX_LENGTH - 1) {
+                    link->in[link->in_used++] = buffer[j];
+                }
+            }
+        }
+    }
+    double elapsed = NowSeconds() - start;
+
+    if (latency_count == 0) return 0;
+    qsort(latencies, latency_count, sizeof(double), CompareDoubles);
+    printf("Sessions: %d over %d connections, think %d ms, bot budget ", sessions, connections, think_ms);
+    if (time_ms) {
+        printf("%d ms\n", time_ms);
+    } else {
+        printf("server default\n");
+    }
+    printf("Bot moves: %ld in %.3f s (%.0f/s), %ld games finished, %ld errors\n", latency_count, elapsed,
+           latency_count / elapsed, games_finished, errors);
+    printf("Latency: p50 %.2f ms, p90 %.2f ms, p99 %.2f ms, max %.2f ms\n", latencies[latency_count / 2] * 1000,
+           latencies[latency_count * 9 / 10] * 1000, latencies[latency_count * 99 / 100] * 1000,
+           latencies[latency_count - 1] * 1000);
+    return 0;
+}
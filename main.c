@@ -0,0 +1,761 @@
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+//
+//      Command line front end: the board, the game against the bot, the
+//      engine protocol and the tools, all through checkers.h
+//
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <pthread.h>
+#include <unistd.h>
+#include "checkers.h"
+
+// Display functions
+void PrintBinary(uint64_t board) {      // Show in binary
+    printf("Binary: ");
+    for (int i = 63; i >= 0; i--) {
+        printf("%d", (int)((board >> i) & 1));
+        if (i % 8 == 0) printf(" ");
+    }
+    printf("\n");
+}
+
+void PrintHex(uint64_t board) {         // Show in hex
+    printf("Hex: 0x%016llX\n", (unsigned long long)board);
+}
+
+void PrintBoard(CheckersGame *game) {
+    printf("\n    a   b   c   d   e   f   g   h\n");
+    printf("  ┏━━━┳━━━┳━━━┳━━━┳━━━┳━━━┳━━━┳━━━┓\n");
+
+    for (int row = 0; row < 8; row++) {
+        printf("%d ┃", 8 - row);
+        for (int col = 0; col < 8; col++) {
+            int bit_pos = CheckersSquareAt(row, col);   // Converts coords to bit pos
+            if (bit_pos < 0) {                          // Print the board grid
+                printf("▓▓▓┃");
+                continue;
+            }
+            int is_red = (game->pieces >> bit_pos) & 1;
+            int is_black = (game->pieces >> (bit_pos + 32)) & 1;    // Offset for condensed 64 bit
+            int is_king = ((game->kings >> bit_pos) | (game->kings >> (bit_pos + 32))) & 1;
+
+            char piece = ' ';
+            if (is_red) {                               // Most effecient labeling
+                piece = is_king ? 'R' : 'r';
+            } else if (is_black) {
+                piece = is_king ? 'B' : 'b';
+            }
+
+            if (piece == ' ') {
+                printf("   ┃");
+            } else {
+                printf(" %c ┃", piece);
+            }
+        }
+        printf(" %d\n", 8 - row);
+
+        if (row < 7) {
+            printf("  ┣━━━╋━━━╋━━━╋━━━╋━━━╋━━━╋━━━╋━━━┫\n");
+        }
+    }
+    printf("  ┗━━━┻━━━┻━━━┻━━━┻━━━┻━━━┻━━━┻━━━┛\n");
+    printf("    a   b   c   d   e   f   g   h\n");
+}
+
+CheckersHistory game_history;           // Positions of the game being played, for repetitions
+
+int MakeMove(CheckersGame *game, const CheckersMove *move) {      // Plays the move and says what it took
+    int flags = CheckersApply(game, move, NULL);
+    CheckersHistoryPush(&game_history, game);
+
+    for (uint32_t b = move->captures; b; b &= b - 1) {
+        char name[3];
+        CheckersSquareName(__builtin_ctz(b), name);
+        printf("Captured %s\n", name);
+    }
+    if (flags & CHECKERS_KINGED) {
+        printf("Kinged!\n");
+    }
+    return flags;
+}
+
+// Bot stuff
+CheckersEngine *bot;
+CheckersLimits bot_limits = {1000, 0, 0};              // 1 second per move unless changed on the command line
+size_t bot_hash_mb = 16;                                // Changed with -hash
+int bot_threads = 1;
+FILE *stats_file;                                       // JSON line per bot move with -stats
+CheckersStats bot_stats;                                // Counters of the last move the bot played
+int bot_stats_kept;
+
+static double Ratio(uint64_t part, uint64_t whole) {
+    return whole ? (double)part / whole : 0.0;
+}
+
+void PrintStats(const CheckersStats *stats) {       // Counters of the bot's last search
+    if (stats->playouts) {          // Tree search, the alpha-beta counters stay at 0
+        printf("Playouts: %llu in %.3f s (%.0f/s), %llu tree nodes\n", (unsigned long long)stats->playouts, stats->seconds,
+               stats->seconds > 0 ? stats->playouts / stats->seconds : 0.0, (unsigned long long)stats->tree_nodes);
+        return;
+    }
+    printf("Nodes: %llu in %.3f s (%.0f/s)\n", (unsigned long long)stats->nodes, stats->seconds,
+           stats->seconds > 0 ? stats->nodes / stats->seconds : 0.0);
+    printf("Move generation: %llu calls, %llu moves (%.1f per call), %llu captures\n",
+           (unsigned long long)stats->movegen_calls, (unsigned long long)stats->moves_generated,
+           Ratio(stats->moves_generated, stats->movegen_calls), (unsigned long long)stats->captures_generated);
+    printf("Hash table: %llu probes, %.1f%% hits, %llu cutoffs, %llu collisions\n",
+           (unsigned long long)stats->tt_probes, 100 * Ratio(stats->tt_hits, stats->tt_probes),
+           (unsigned long long)stats->tt_cutoffs, (unsigned long long)stats->tt_collisions);
+    printf("Cutoffs: %llu (%.1f%% of expanded nodes, %.1f%% on the first move)\n", (unsigned long long)stats->cutoffs,
+           100 * Ratio(stats->cutoffs, stats->expanded), 100 * Ratio(stats->first_move_cutoffs, stats->cutoffs));
+    printf("Branching factor: %.2f moves searched per expanded node\n", Ratio(stats->moves_searched, stats->expanded));
+    for (int i = 0; i < stats->iterations; i++) {       // Effective branching factor is the node growth per depth
+        printf("  depth %2d: %10llu nodes %9.3f ms", i + 1, (unsigned long long)stats->iteration_nodes[i],
+               stats->iteration_seconds[i] * 1000);
+        if (i > 0) printf("  x%.2f", Ratio(stats->iteration_nodes[i], stats->iteration_nodes[i - 1]));
+        printf("\n");
+    }
+}
+
+void WriteStatsJSON(FILE *file, const CheckersStats *stats, const CheckersMove *move) {
+    char text[CHECKERS_MOVE_TEXT];
+    CheckersFormatMove(move, text);
+    fprintf(file, "{\"move\":\"%s\",\"seconds\":%.6f,\"nodes\":%llu,\"movegen_calls\":%llu,\"moves_generated\":%llu,"
+            "\"captures_generated\":%llu,\"tt_probes\":%llu,\"tt_hits\":%llu,\"tt_cutoffs\":%llu,\"tt_collisions\":%llu,"
+            "\"expanded\":%llu,\"moves_searched\":%llu,\"cutoffs\":%llu,\"first_move_cutoffs\":%llu,\"playouts\":%llu,"
+            "\"tree_nodes\":%llu,\"iterations\":[",
+            text, stats->seconds, (unsigned long long)stats->nodes, (unsigned long long)stats->movegen_calls,
+            (unsigned long long)stats->moves_generated, (unsigned long long)stats->captures_generated,
+            (unsigned long long)stats->tt_probes, (unsigned long long)stats->tt_hits, (unsigned long long)stats->tt_cutoffs,
+            (unsigned long long)stats->tt_collisions, (unsigned long long)stats->expanded,
+            (unsigned long long)stats->moves_searched, (unsigned long long)stats->cutoffs,
+            (unsigned long long)stats->first_move_cutoffs, (unsigned long long)stats->playouts,
+            (unsigned long long)stats->tree_nodes);
+    for (int i = 0; i < stats->iterations; i++) {
+        fprintf(file, "%s{\"depth\":%d,\"nodes\":%llu,\"seconds\":%.6f}", i ? "," : "", i + 1,
+                (unsigned long long)stats->iteration_nodes[i], stats->iteration_seconds[i]);
+    }
+    fprintf(file, "]}\n");
+    fflush(file);
+}
+
+void MakeBotMove(CheckersGame *game) {
+    CheckersMove selected_move;
+
+    CheckersEngineSetHistory(bot, &game_history);
+    if (!CheckersSearch(bot, game, &selected_move, NULL)) {
+        printf("Bot has no moves\n");
+        return;
+    }
+
+    printf("Bot: %c%d", 'a' + selected_move.from_col, 8 - selected_move.from_row);
+    for (int i = 0; i < selected_move.hops; i++) {      // Every landing square of a jump sequence
+        char name[3];
+        CheckersSquareName(selected_move.path[i], name);
+        printf(" %s", name);
+    }
+    printf("\n");
+    bot_stats_kept = CheckersEngineStats(bot, &bot_stats);     // Kept apart, pondering searches too
+    if (stats_file && bot_stats_kept) WriteStatsJSON(stats_file, &bot_stats, &selected_move);
+    MakeMove(game, &selected_move);
+}
+
+// Pondering
+// While the player thinks, the bot searches the position in front of them with no limits, so every
+// reply gets looked at and scored into the hash table the bot's own search uses. When the player's move
+// comes in the bot starts from that work instead of an empty table: a depth limited search finishes
+// far sooner, a timed one gets deeper. The search is stopped before anything else touches the engine,
+// and the bot's next search is told it continues the ponder, so the ponder's entries aren't aged out.
+int ponder_enabled = 1;         // -noponder turns it off
+CheckersGame ponder_game;
+pthread_t ponder_thread;
+int pondering;                  // Thread started and not joined yet
+
+static void *PonderThread(void *arg) {
+    CheckersMove move;
+    CheckersSearch(bot, &ponder_game, &move, NULL);     // Only the table is wanted
+    return NULL;
+}
+
+void StartPonder(const CheckersGame *game) {
+    if (!ponder_enabled || pondering) return;
+    CheckersMove moves[CHECKERS_MAX_MOVES];
+    CheckersHistory history = game_history;
+    ponder_game = *game;
+    if (CheckersLegalMoves(game, moves) == 1) {        // Forced reply, so think about the bot's turn after it
+        CheckersApply(&ponder_game, &moves[0], NULL);
+        CheckersHistoryPush(&history, &ponder_game);
+    }
+    CheckersEngineSetHistory(bot, &history);
+    CheckersLimits none = {0, 0, 0};
+    CheckersEngineSetLimits(bot, &none);
+    CheckersEngineStop(bot, 0);
+    pondering = pthread_create(&ponder_thread, NULL, PonderThread, NULL) == 0;
+    if (!pondering) CheckersEngineSetLimits(bot, &bot_limits);
+}
+
+void StopPonder() {
+    if (!pondering) return;
+    CheckersEngineStop(bot, 1);
+    pthread_join(ponder_thread, NULL);
+    CheckersEngineStop(bot, 0);
+    CheckersEngineSetLimits(bot, &bot_limits);
+    CheckersEngineContinue(bot);
+    pondering = 0;
+}
+
+// Perft (move generator benchmark)
+static double NowSeconds() {            // Monotonic wall clock for benchmarks
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+void RunPerft(CheckersGame *game, int depth) {     // Prints a divide per root move plus nodes/sec
+    CheckersMove moves[CHECKERS_MAX_MOVES];
+    int count = CheckersLegalMoves(game, moves);
+    uint64_t total = 0;
+    double start = NowSeconds();
+
+    for (int i = 0; i < count; i++) {
+        CheckersGame child = *game;
+        CheckersApply(&child, &moves[i], NULL);
+        uint64_t nodes = depth > 1 ? CheckersPerft(&child, depth - 1) : 1;
+        char text[CHECKERS_MOVE_TEXT];
+        CheckersFormatMove(&moves[i], text);
+        printf("%s: %llu\n", text, (unsigned long long)nodes);
+        total += nodes;
+    }
+
+    double elapsed = NowSeconds() - start;
+    printf("\nDepth: %d\n", depth);
+    printf("Nodes: %llu\n", (unsigned long long)total);
+    printf("Time: %.3f s\n", elapsed);
+    printf("Nodes/sec: %.0f\n", elapsed > 0 ? total / elapsed : 0.0);
+}
+
+void RunMctsBench(CheckersGame *game, int time_ms, int max_threads) {     // Playouts/sec of the tree search on 1, 2, 4... threads
+    CheckersLimits limits = {time_ms, 0, 0};
+    CheckersEngineSetLimits(bot, &limits);
+    CheckersEngineSetMcts(bot, 1);
+    for (int threads = 1;; threads *= 2) {
+        if (threads > max_threads) threads = max_threads;
+        CheckersEngineSetThreads(bot, threads);
+        CheckersMove move;
+        CheckersSearchInfo info;
+        CheckersStats stats;
+        if (!CheckersSearch(bot, game, &move, &info)) {
+            printf("No moves\n");
+            return;
+        }
+        CheckersEngineStats(bot, &stats);
+        char text[CHECKERS_MOVE_TEXT];
+        CheckersFormatMove(&move, text);
+        printf("Threads %2d: %llu playouts in %.3f s (%.0f/s), %llu tree nodes, depth %d, best %s score %d\n", threads,
+               (unsigned long long)info.nodes, info.seconds, info.seconds > 0 ? info.nodes / info.seconds : 0.0,
+               (unsigned long long)stats.tree_nodes, info.depth, text, info.score);
+        if (threads >= max_threads) break;
+    }
+}
+
+
+// File I/O
+int SaveGame(CheckersGame *game, const char *filename);
+int LoadGame(CheckersGame *game, const char *filename);
+
+int SaveGame(CheckersGame *game, const char *filename) {
+    FILE *file = fopen(filename, "w");
+    if (!file) {
+        printf("Error: Could not open file '%s' for writing\n", filename);
+        return 0;
+    }
+
+    fprintf(file, "%llu\n", (unsigned long long)game->pieces); // Logs all three of the game state values
+    fprintf(file, "%llu\n", (unsigned long long)game->kings);
+    fprintf(file, "%d\n", game->current_turn);
+
+    fclose(file);
+    printf("Game saved to '%s'\n", filename);
+    return 1;
+}
+
+int LoadGame(CheckersGame *game, const char *filename) {
+    FILE *file = fopen(filename, "r");
+    if (!file) {
+        printf("Error: Could not open file '%s' for reading\n", filename);
+        return 0;
+    }
+
+    unsigned long long pieces, kings;
+    int turn;
+    if (fscanf(file, "%llu %llu %d", &pieces, &kings, &turn) != 3) {
+        printf("Error: Invalid file format in '%s'\n", filename);
+        fclose(file);
+        return 0;
+    }
+    fclose(file);
+
+    if (!CheckersSetPosition(game, pieces, kings, turn)) {       // Only changes the game if it's a real position
+        printf("Error: Invalid position in '%s'\n", filename);
+        return 0;
+    }
+    printf("Game loaded from '%s'\n", filename);
+    return 1;
+}
+
+// Engine protocol
+// Line based commands on stdin for match managers, in the spirit of UCI. Nothing is drawn, the only
+// output is replies, info lines and best moves. Moves are written like "c3-d4" or "e3xg5xe7".
+//   engine                         id name checkers, then engineok
+//   isready                        readyok, answered even while searching
+//   setoption hash {MB} | threads {n}
+//   newgame                        clears the hash table
+//   position startpos [moves ...]
+//   position bits {pieces} {kings} {turn} [moves ...]
+//   go [depth n] [movetime ms] [nodes n] [rtime ms] [btime ms] [rinc ms] [binc ms] [infinite]
+//   stop                           ends the search, the best move so far is sent. After go infinite
+//                                  bestmove always waits for it, even once the search is over
+//   quit
+// The search runs on its own thread, so stop and isready are read while it thinks.
+typedef struct {
+    CheckersGame game;          // Position set up by the last position command
+    CheckersHistory history;    // Its start and the moves after it
+    CheckersGame searched;      // Copy the search thread works from
+    pthread_t thread;
+    int searching;              // Thread started and not joined yet
+    int infinite;               // go infinite: bestmove waits for stop even when the search ends first
+    int stopped;                // stop came in, under lock
+    pthread_mutex_t lock;
+    pthread_cond_t stop_signal;
+} ProtocolState;
+
+static void PrintSearchInfo(const CheckersSearchInfo *info, void *user) {    // "info depth 7 score 35 nodes 81234 nps 950000 time 85 pv c3-d4"
+    char text[CHECKERS_MOVE_TEXT];
+    CheckersFormatMove(&info->best, text);
+    printf("info depth %d score ", info->depth);
+    if (info->plies_to_end) {
+        printf("%s %d", info->score > 0 ? "win" : "loss", info->plies_to_end);     // Plies to the end
+    } else {
+        printf("%d", info->score);
+    }
+    printf(" nodes %llu nps %.0f time %.0f pv %s\n", (unsigned long long)info->nodes,
+           info->seconds > 0 ? info->nodes / info->seconds : 0.0, info->seconds * 1000, text);
+    fflush(stdout);
+}
+
+static void *ProtocolSearchThread(void *arg) {
+    ProtocolState *state = arg;
+    CheckersMove move;
+    CheckersSearchInfo info;
+    char text[CHECKERS_MOVE_TEXT] = "none";
+    if (CheckersSearch(bot, &state->searched, &move, &info)) {
+        CheckersFormatMove(&move, text);
+        if (info.nodes == 0) PrintSearchInfo(&info, NULL);     // Forced or book move, nothing searched reported it
+    }
+    pthread_mutex_lock(&state->lock);
+    while (state->infinite && !state->stopped) {
+        pthread_cond_wait(&state->stop_signal, &state->lock);
+    }
+    pthread_mutex_unlock(&state->lock);
+    printf("bestmove %s\n", text);
+    fflush(stdout);
+    return NULL;
+}
+
+static void StopProtocolSearch(ProtocolState *state) {     // Waits for the bestmove line
+    if (!state->searching) return;
+    CheckersEngineStop(bot, 1);
+    pthread_mutex_lock(&state->lock);
+    state->stopped = 1;
+    pthread_cond_signal(&state->stop_signal);
+    pthread_mutex_unlock(&state->lock);
+    pthread_join(state->thread, NULL);
+    state->searching = 0;
+}
+
+// Rest of a position command, still in strtok. game and history are only changed when all of it is valid
+static int ParseProtocolPosition(CheckersGame *game, CheckersHistory *history) {
+    CheckersGame position;
+    CheckersHistory played;
+    char *token = strtok(NULL, " \t");
+    if (token && strcmp(token, "startpos") == 0) {
+        CheckersNewGame(&position);
+    } else if (token && strcmp(token, "bits") == 0) {
+        char *pieces = strtok(NULL, " \t"), *kings = strtok(NULL, " \t"), *turn = strtok(NULL, " \t");
+        if (!turn || !CheckersSetPosition(&position, strtoull(pieces, NULL, 10), strtoull(kings, NULL, 10), atoi(turn))) return 0;
+    } else {
+        return 0;
+    }
+
+    CheckersHistoryStart(&played, &position);
+    token = strtok(NULL, " \t");
+    if (token && strcmp(token, "moves") == 0) {
+        while ((token = strtok(NULL, " \t"))) {
+            CheckersMove move;
+            if (!CheckersParseMove(&position, token, &move)) {
+                printf("info string illegal move %s\n", token);
+                return 0;
+            }
+            CheckersApply(&position, &move, NULL);
+            CheckersHistoryPush(&played, &position);
+        }
+    }
+    *game = position;
+    *history = played;
+    return 1;
+}
+
+static void StartProtocolSearch(ProtocolState *state) {        // Rest of a go command, still in strtok
+    CheckersLimits limits = {0, 0, 0};
+    int remaining[2] = {0, 0}, increment[2] = {0, 0}, limited = 0;
+    char *token;
+    state->infinite = 0;
+    state->stopped = 0;
+    while ((token = strtok(NULL, " \t"))) {
+        char *value = strcmp(token, "infinite") == 0 ? NULL : strtok(NULL, " \t");
+        if (strcmp(token, "infinite") == 0) {
+            limited = 1;        // No limits at all
+            state->infinite = 1;
+        } else if (!value) {
+            break;
+        } else if (strcmp(token, "depth") == 0) {
+            limits.max_depth = atoi(value);
+        } else if (strcmp(token, "movetime") == 0) {
+            limits.time_ms = atoi(value);
+        } else if (strcmp(token, "nodes") == 0) {
+            limits.max_nodes = strtoull(value, NULL, 10);
+        } else if (strcmp(token, "rtime") == 0 || strcmp(token, "btime") == 0) {
+            remaining[token[0] == 'b'] = atoi(value);
+        } else if (strcmp(token, "rinc") == 0 || strcmp(token, "binc") == 0) {
+            increment[token[0] == 'b'] = atoi(value);
+        } else {
+            continue;
+        }
+        limited = 1;
+    }
+
+    int turn = state->game.current_turn;
+    if (!limits.time_ms && remaining[turn] > 0) {       // Clock: a slice of what's left plus most of the increment
+        limits.time_ms = remaining[turn] / 25 + increment[turn] * 3 / 4;
+        if (limits.time_ms > remaining[turn] / 2) limits.time_ms = remaining[turn] / 2;
+        if (limits.time_ms < 1) limits.time_ms = 1;
+    }
+    CheckersEngineSetLimits(bot, limited ? &limits : &bot_limits);     // Plain go keeps the command line limits
+    CheckersEngineSetHistory(bot, &state->history);
+    CheckersEngineStop(bot, 0);
+    state->searched = state->game;
+    state->searching = pthread_create(&state->thread, NULL, ProtocolSearchThread, state) == 0;
+}
+
+int RunProtocol() {
+    ProtocolState state;
+    CheckersNewGame(&state.game);
+    CheckersHistoryStart(&state.history, &state.game);
+    state.searching = 0;
+    pthread_mutex_init(&state.lock, NULL);
+    pthread_cond_init(&state.stop_signal, NULL);
+    CheckersEngineSetInfo(bot, PrintSearchInfo, NULL);
+    setvbuf(stdout, NULL, _IOLBF, 0);
+    static char line[65536];            // Long games make long move lists
+
+    while (fgets(line, sizeof(line), stdin)) {
+        line[strcspn(line, "\r\n")] = 0;
+        char *command = strtok(line, " \t");
+        if (!command) continue;
+
+        if (strcmp(command, "engine") == 0) {
+            printf("id name checkers\nengineok\n");
+        } else if (strcmp(command, "isready") == 0) {
+            printf("readyok\n");
+        } else if (strcmp(command, "stop") == 0) {
+            StopProtocolSearch(&state);
+        } else if (strcmp(command, "quit") == 0) {
+            break;
+        } else if (strcmp(command, "go") == 0) {
+            StopProtocolSearch(&state);
+            StartProtocolSearch(&state);
+        } else if (strcmp(command, "position") == 0) {
+            StopProtocolSearch(&state);
+            if (!ParseProtocolPosition(&state.game, &state.history)) printf("info string bad position\n");
+        } else if (strcmp(command, "newgame") == 0) {
+            StopProtocolSearch(&state);
+            CheckersEngineClear(bot);
+        } else if (strcmp(command, "setoption") == 0) {
+            StopProtocolSearch(&state);
+            char *name = strtok(NULL, " \t"), *value = strtok(NULL, " \t");
+            if (name && value && strcmp(name, "hash") == 0) {
+                if (!CheckersEngineSetHash(bot, strtoull(value, NULL, 10))) printf("info string hash table too big\n");
+            } else if (name && value && strcmp(name, "threads") == 0) {
+                CheckersEngineSetThreads(bot, atoi(value));
+            } else {
+                printf("info string unknown option\n");
+            }
+        } else {
+            printf("info string unknown command %s\n", command);
+        }
+    }
+    StopProtocolSearch(&state);
+    return 0;
+}
+
+int main(int argc, char *argv[]) {
+    CheckersInit();
+    CheckersGame game;
+
+    char *args[8];          // Positional arguments once the options are taken out
+    int arg_count = 0;
+    int limits_set = 0;
+    int workers = sysconf(_SC_NPROCESSORS_ONLN);
+    int binary = 0;
+    int static_eval = 0;
+    int hash_set = 0;
+    const char *tb_file = NULL;
+    const char *book_file = NULL;
+    const char *stats_name = NULL;
+    const char *weights_file = NULL;
+    CheckersWeights bot_weights;
+    int iterations = 500;
+    int use_mcts = 0;
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "-time") == 0 && i + 1 < argc) {       // Bot budget per move
+            bot_limits.time_ms = atoi(argv[++i]);
+            limits_set = 1;
+        } else if (strcmp(argv[i], "-depth") == 0 && i + 1 < argc) {
+            bot_limits.max_depth = atoi(argv[++i]);
+            limits_set = 1;
+        } else if (strcmp(argv[i], "-nodes") == 0 && i + 1 < argc) {
+            bot_limits.max_nodes = strtoull(argv[++i], NULL, 10);
+            limits_set = 1;
+        } else if (strcmp(argv[i], "-workers") == 0 && i + 1 < argc) {    // Worker threads for selfplay and analyze
+            workers = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "-binary") == 0) {                    // analyze reads 17 byte positions
+            binary = 1;
+        } else if (strcmp(argv[i], "-eval") == 0) {                      // analyze without searching
+            static_eval = 1;
+        } else if (strcmp(argv[i], "-hash") == 0 && i + 1 < argc) {       // Transposition table size in MB
+            bot_hash_mb = strtoull(argv[++i], NULL, 10);
+            hash_set = 1;
+        } else if (strcmp(argv[i], "-threads") == 0 && i + 1 < argc) {
+            bot_threads = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "-tb") == 0 && i + 1 < argc) {         // Endgame tablebase file
+            tb_file = argv[++i];
+        } else if (strcmp(argv[i], "-book") == 0 && i + 1 < argc) {       // Opening book file
+            book_file = argv[++i];
+        } else if (strcmp(argv[i], "-stats") == 0 && i + 1 < argc) {      // JSON search stats per bot move
+            stats_name = argv[++i];
+        } else if (strcmp(argv[i], "-noponder") == 0) {                  // Bot idles on the player's turn
+            ponder_enabled = 0;
+        } else if (strcmp(argv[i], "-weights") == 0 && i + 1 < argc) {    // Evaluation weights from tune
+            weights_file = argv[++i];
+        } else if (strcmp(argv[i], "-iterations") == 0 && i + 1 < argc) { // Steps for tune
+            iterations = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "-mcts") == 0) {                      // Bot plays Monte Carlo tree search
+            use_mcts = 1;
+        } else if (arg_count < 8) {
+            args[arg_count++] = argv[i];
+        }
+    }
+
+    CheckersDefaultWeights(&bot_weights);
+    if (weights_file && !CheckersLoadWeights(weights_file, &bot_weights)) {
+        printf("Error: Could not read weights '%s'\n", weights_file);
+        return 1;
+    }
+    CheckersNewGame(&game);
+    CheckersHistoryStart(&game_history, &game);
+
+    if (arg_count >= 2 && strcmp(args[0], "perft") == 0) {      // checkers perft {depth} [file]
+        if (arg_count >= 3 && !LoadGame(&game, args[2])) return 1;
+        RunPerft(&game, atoi(args[1]));
+        return 0;
+    }
+
+    if (arg_count >= 3 && strcmp(args[0], "tbgen") == 0) {      // checkers tbgen {pieces} {file}
+        return CheckersTBGenerate(atoi(args[1]), args[2]) ? 0 : 1;
+    }
+
+    if (arg_count >= 4 && strcmp(args[0], "bookgen") == 0) {    // checkers bookgen {games} {plies} {file} [archive.ckg]
+        return CheckersBookBuild(atoi(args[1]), atoi(args[2]), arg_count >= 5 ? args[4] : NULL, args[3], &bot_weights) ? 0 : 1;
+    }
+
+    if (arg_count >= 2 && strcmp(args[0], "analyze") == 0) {    // checkers analyze {file or -}
+        if (static_eval) return CheckersAnalyzeEval(args[1], binary, &bot_weights) ? 0 : 1;
+        CheckersLimits limits = {0, 8, 0};
+        if (!hash_set) bot_hash_mb = 1;         // Cleared every position, so small by default
+        return CheckersAnalyze(args[1], binary, workers, limits_set ? &bot_limits : &limits, bot_hash_mb, tb_file,
+                               &bot_weights) ? 0 : 1;
+    }
+
+    if (arg_count >= 2 && strcmp(args[0], "replay") == 0) {     // checkers replay {file.ckg}
+        return CheckersReplay(args[1]) ? 0 : 1;
+    }
+
+    if (arg_count >= 3 && strcmp(args[0], "selfplay") == 0) {   // checkers selfplay {games} {file}
+        CheckersLimits limits = {0, 4, 0};                      // Quick games unless the limits were given
+        return CheckersSelfPlay(atoi(args[1]), workers, limits_set ? &bot_limits : &limits, bot_hash_mb, args[2],
+                                &bot_weights) ? 0 : 1;
+    }
+
+    if (arg_count >= 3 && strcmp(args[0], "tunegen") == 0) {    // checkers tunegen {archive.ckg} {positions}
+        return CheckersTuneExtract(args[1], args[2]) ? 0 : 1;
+    }
+
+    if (arg_count >= 3 && strcmp(args[0], "tune") == 0) {       // checkers tune {positions} {weights}
+        return CheckersTune(args[1], args[2], workers, iterations, &bot_weights) ? 0 : 1;
+    }
+
+    bot = CheckersEngineNew(bot_hash_mb, bot_threads);
+    if (!bot) {
+        printf("Error: Could not allocate %zu MB hash table\n", bot_hash_mb);
+        return 1;
+    }
+    CheckersEngineSetLimits(bot, &bot_limits);
+    CheckersEngineSetWeights(bot, &bot_weights);
+    if (use_mcts) {
+        CheckersEngineSetMcts(bot, 1);
+        ponder_enabled = 0;         // The tree isn't kept between moves, so there's nothing to ponder into
+    }
+    if (arg_count >= 2 && strcmp(args[0], "mcts") == 0) {       // checkers mcts {ms} [file], playouts/sec up to -threads
+        if (arg_count >= 3 && !LoadGame(&game, args[2])) return 1;
+        RunMctsBench(&game, atoi(args[1]), bot_threads);
+        return 0;
+    }
+    if (tb_file && !CheckersEngineLoadTablebase(bot, tb_file)) {
+        printf("Error: Could not open tablebase '%s'\n", tb_file);
+        return 1;
+    }
+    if (book_file && !CheckersEngineLoadBook(bot, book_file, (uint64_t)time(NULL))) {
+        printf("Error: Could not open book '%s'\n", book_file);
+        return 1;
+    }
+
+    if (stats_name && !(stats_file = fopen(stats_name, "a"))) {
+        printf("Error: Could not open file '%s' for writing\n", stats_name);
+        return 1;
+    }
+
+    if (arg_count >= 1 && strcmp(args[0], "engine") == 0) {     // checkers engine, text protocol on stdin/stdout
+        return RunProtocol();
+    }
+
+    printf("-------------------------------- Single Player Checkers --------------------------------\n");
+    printf("Input options: 'xy xy' (c3 d4, c3 e5 c7 for a jump sequence), 'binary', 'hex', 'stats', 'save {name}', 'load {name}', 'quit'\n");
+    printf("-------------------------------- ---------------------- --------------------------------\n");
+
+    int entered[CHECKERS_MAX_HOPS + 1];     // Squares typed so far for a jump sequence, then the rest are asked for
+    int entered_count = 0;
+
+    while (CheckersStatus(&game, &game_history) == CHECKERS_PLAYING) {
+        PrintBoard(&game);
+
+        if (game.current_turn == 0) {   // Alternate 0,1 (player,bot)
+            if (CheckersMustCapture(&game)) {   // "Mandatory" capture clause
+                printf("You must capture\n");
+            }
+
+            char input[20];         // User input
+            if (entered_count > 0) {        // Prompts chaining messages
+                char name[3];
+                CheckersSquareName(entered[entered_count - 1], name);
+                printf("\nChain jump on %s ", name);
+            } else {
+                printf("\nYour move (r): ");
+            }
+
+            StartPonder(&game);
+            char *line = fgets(input, sizeof(input), stdin);
+            StopPonder();
+            if (line == NULL) break;
+
+            input[strcspn(input, "\n")] = 0;
+
+            if (strcmp(input, "binary") == 0) {     // Display commands
+                PrintBinary(game.pieces);
+                continue;
+            } else if (strcmp(input, "hex") == 0) {
+                PrintHex(game.pieces);
+                continue;
+            } else if (strcmp(input, "stats") == 0) {      // What the bot's last search did
+                CheckersStats stats;
+                if (!CheckersEngineStats(bot, &stats)) {
+                    printf("Stats were left out of this build\n");
+                } else if (bot_stats_kept) {
+                    PrintStats(&bot_stats);
+                } else {
+                    printf("The bot hasn't moved yet\n");
+                }
+                continue;
+            } else if (strcmp(input, "quit") == 0) {
+                break;
+            } else if (strncmp(input, "save ", 5) == 0) {
+                SaveGame(&game, input + 5);
+                continue;
+            } else if (strncmp(input, "load ", 5) == 0) {       // Resets variables upon load
+                if (LoadGame(&game, input + 5)) {
+                    CheckersHistoryStart(&game_history, &game);
+                    entered_count = 0;
+                }
+                continue;
+            }
+
+            int squares[CHECKERS_MAX_HOPS + 1];
+            int count = CheckersParseSquares(input, squares, CHECKERS_MAX_HOPS + 1);
+            if (count == 0 || (entered_count == 0 && count < 2)) {
+                printf("Invalid format! Use algebraic (a3 b4)\n");
+                continue;
+            }
+            int skip = entered_count > 0 && squares[0] == entered[entered_count - 1];     // "e5 c7" repeats the square it's on
+            int total = entered_count;
+            for (int i = skip; i < count && total <= CHECKERS_MAX_HOPS; i++) {
+                entered[total++] = squares[i];
+            }
+
+            CheckersMove move;
+            int found = CheckersFindMove(&game, entered, total, &move);
+            if (found == 2) {           // Performs the whole move once it's complete
+                MakeMove(&game, &move);
+                entered_count = 0;
+            } else if (found == 1) {    // Part of a jump sequence, ask for the rest
+                entered_count = total;
+                printf("Chain jump! Continue capturing.\n");
+            } else {
+                printf("Invalid move ");
+                if (CheckersMustCapture(&game)) {
+                    printf("You must capture \n");
+                }
+            }
+        } else {        // Calls bot to move, which passes the turn back
+            MakeBotMove(&game);
+        }
+    }
+
+    PrintBoard(&game);
+    printf("\nGame Over ");
+
+    uint64_t red_pieces = game.pieces & 0xFFFFFFFF;
+    uint64_t black_pieces = (game.pieces >> 32) & 0xFFFFFFFF;
+    int status = CheckersStatus(&game, &game_history);
+
+    if (red_pieces == 0) {      // Conditions: All pieces for player is gone, no valid moves exist, or quit
+        printf("Bot wins!\n");
+    } else if (black_pieces == 0) {
+        printf("You win! \n");
+    } else if (status == CHECKERS_DRAW) {
+        printf("Draw, %s\n", game.reversible >= CHECKERS_MOVE_RULE ? "40 moves each with no capture and no man moving"
+                                                                    : "the same position came up three times");
+    } else if (status != CHECKERS_PLAYING) {
+        printf("%s has no moves ", game.current_turn == 0 ? "You" : "Bot");
+        printf("%s wins\n", status == CHECKERS_BLACK_WON ? "Bot" : "You");
+    } else {
+        printf("Draw\n");
+    }
+
+    if (stats_file) fclose(stats_file);
+    CheckersEngineFree(bot);
+    return 0;
+}
@@ -0,0 +1,503 @@
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+//
+//      Game server: many player against bot games in one process. One epoll
+//      loop owns the sockets and the games, bot moves are searched by a pool
+//      of worker threads with an engine each.
+//
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+
+#define _GNU_SOURCE             // accept4
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdarg.h>
+#include <errno.h>
+#include <pthread.h>
+#include <unistd.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <arpa/inet.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include "checkers.h"
+
+// Protocol
+// Line based over TCP or a Unix socket. A connection can hold any number of games, the player is red
+// and moves first in each. Replies for one game come in order, games don't wait on each other.
+//   new                        game {id}
+//   move {id} {move} [ms]      bot {id} {move} {state} once the bot has answered, within ms if given
+//                              over {id} {state} if the move ended the game, else illegal {id} or busy {id}
+//   board {id}                 board {id} {pieces} {kings} {turn}
+//   end {id}                   ended {id}, the id can be handed out again
+//   stats                      stats {games} {queued} {bot moves}
+// state is playing, red, black or draw. Anything else gets an error line.
+#define LINE_MAX_LENGTH 256
+#define READ_SIZE       16384
+
+typedef struct Connection Connection;
+
+typedef struct Session Session;
+struct Session {                // One game, touched only by the loop unless busy
+    CheckersGame game;
+    CheckersHistory history;
+    Connection *connection;     // NULL once its connection has closed
+    Session *prev, *next;       // The connection's other games
+    int id;
+    int busy;                   // A bot move is queued or being searched, the worker reads the game
+    int ended;                  // Freed when the bot move comes back
+};
+
+struct Connection {
+    int fd;
+    char in[LINE_MAX_LENGTH];   // Start of a line still being received
+    int in_used;
+    char *out;                  // Replies the socket hasn't taken yet
+    size_t out_used, out_sent, out_size;
+    int writing;                // Waiting on EPOLLOUT
+    Session *sessions;
+};
+
+typedef struct Job Job;
+struct Job {                    // A bot move, from the loop to a worker and back
+    Session *session;
+    int time_ms;
+    CheckersMove move;
+    int found;
+    Job *next;
+};
+
+typedef struct {
+    Job *head, *tail;
+} JobList;
+
+typedef struct {
+    CheckersEngine *engine;
+    pthread_t thread;
+} Worker;
+
+// Server state
+CheckersLimits server_limits = {100, 0, 0};    // Per bot move unless the move asks for a time
+size_t server_hash_mb = 16;                     // Per worker
+Session **sessions;             // By id, NULL for free ids
+int session_capacity;
+int *free_ids;                  // Stack of ids handed back by end
+int free_count;
+int next_id;
+int live_sessions;
+uint64_t bot_moves;
+
+pthread_mutex_t job_lock = PTHREAD_MUTEX_INITIALIZER;
+pthread_cond_t job_ready = PTHREAD_COND_INITIALIZER;
+JobList queued;                 // Waiting for a worker
+JobList finished;               // Waiting for the loop
+int queued_count;
+int done_fd;                    // eventfd the workers bump when they finish a job
+
+static void JobPush(JobList *list, Job *job) {
+    job->next = NULL;
+    if (list->tail) {
+        list->tail->next = job;
+    } else {
+        list->head = job;
+    }
+    list->tail = job;
+}
+
+static Job *JobTakeAll(JobList *list) {
+    Job *jobs = list->head;
+    list->head = list->tail = NULL;
+    return jobs;
+}
+
+// Workers
+static void *WorkerMain(void *arg) {
+    Worker *worker = arg;
+    pthread_mutex_lock(&job_lock);
+    for (;;) {
+        while (!queued.head) {
+            pthread_cond_wait(&job_ready, &job_lock);
+        }
+        Job *job = queued.head;
+        queued.head = job->next;
+        if (!queued.head) queued.tail = NULL;
+        queued_count--;
+        pthread_mutex_unlock(&job_lock);
+
+        CheckersLimits limits = server_limits;
+        if (job->time_ms > 0) limits.time_ms = job->time_ms;
+        CheckersEngineSetLimits(worker->engine, &limits);
+        CheckersEngineSetHistory(worker->engine, &job->session->history);
+        job->found = CheckersSearch(worker->engine, &job->session->game, &job->move, NULL);
+
+        pthread_mutex_lock(&job_lock);
+        JobPush(&finished, job);
+        uint64_t one = 1;
+        if (write(done_fd, &one, sizeof(one)) < 0) {}      // Only a wake up, a full counter is already one
+    }
+    return NULL;
+}
+
+// Sessions
+static Session *NewSession(Connection *connection) {
+    Session *session = calloc(1, sizeof(Session));
+    if (!session) return NULL;
+    int id = free_count ? free_ids[--free_count] : next_id;
+    if (id >= session_capacity) {
+        int capacity = session_capacity ? session_capacity * 2 : 1024;
+        Session **grown = realloc(sessions, capacity * sizeof(Session *));
+        int *grown_ids = realloc(free_ids, capacity * sizeof(int));
+        if (grown) sessions = grown;
+        if (grown_ids) free_ids = grown_ids;
+        if (!grown || !grown_ids) {
+            free(session);
+            return NULL;
+        }
+        memset(sessions + session_capacity, 0, (capacity - session_capacity) * sizeof(Session *));
+        session_capacity = capacity;
+    }
+    if (id == next_id) next_id++;
+    session->id = id;
+    session->connection = connection;
+    session->next = connection->sessions;
+    if (session->next) session->next->prev = session;
+    connection->sessions = session;
+    CheckersNewGame(&session->game);
+    CheckersHistoryStart(&session->history, &session->game);
+    sessions[id] = session;
+    live_sessions++;
+    return session;
+}
+
+static void FreeSession(Session *session) {
+    if (session->connection) {
+        if (session->prev) {
+            session->prev->next = session->next;
+        } else {
+            session->connection->sessions = session->next;
+        }
+        if (session->next) session->next->prev = session->prev;
+    }
+    sessions[session->id] = NULL;
+    free_ids[free_count++] = session->id;
+    live_sessions--;
+    free(session);
+}
+
+static const char *StateName(int status) {
+    return status == CHECKERS_RED_WON ? "red" : status == CHECKERS_BLACK_WON ? "black" :
+           status == CHECKERS_DRAW ? "draw" : "playing";
+}
+
+// Connections
+static void WatchWrites(int epoll_fd, Connection *connection, int writing) {
+    if (connection->writing == writing) return;
+    struct epoll_event event = {.events = EPOLLIN | EPOLLRDHUP | (writing ? EPOLLOUT : 0), .data.ptr = connection};
+    epoll_ctl(epoll_fd, EPOLL_CTL_MOD, connection->fd, &event);
+    connection->writing = writing;
+}
+
+static void Flush(int epoll_fd, Connection *connection) {     // Sends what the socket takes, the rest waits for EPOLLOUT
+    while (connection->out_sent < connection->out_used) {
+        ssize_t sent = send(connection->fd, connection->out + connection->out_sent,
+                            connection->out_used - connection->out_sent, MSG_NOSIGNAL);
+        if (sent <= 0) break;
+        connection->out_sent += sent;
+    }
+    if (connection->out_sent == connection->out_used) connection->out_sent = connection->out_used = 0;
+    WatchWrites(epoll_fd, connection, connection->out_used > 0);
+}
+
+static void Reply(Connection *connection, const char *format, ...) __attribute__((format(printf, 2, 3)));
+
+static void Reply(Connection *connection, const char *format, ...) {      // Queued, sent by Flush
+    if (connection->out_size - connection->out_used < LINE_MAX_LENGTH) {
+        size_t size = connection->out_size ? connection->out_size * 2 : 4096;
+        char *out = realloc(connection->out, size);
+        if (!out) return;
+        connection->out = out;
+        connection->out_size = size;
+    }
+    va_list args;
+    va_start(args, format);
+    int length = vsnprintf(connection->out + connection->out_used, LINE_MAX_LENGTH, format, args);
+    va_end(args);
+    if (length > 0) connection->out_used += length < LINE_MAX_LENGTH ? length : LINE_MAX_LENGTH - 1;
+}
+
+static void CloseConnection(int epoll_fd, Connection *connection) {
+    epoll_ctl(epoll_fd, EPOLL_CTL_DEL, connection->fd, NULL);
+    close(connection->fd);
+    Session *next;
+    for (Session *session = connection->sessions; session; session = next) {     // Its games go too, busy ones once the bot is done
+        next = session->next;
+        session->connection = NULL;
+        if (!session->busy) FreeSession(session);
+    }
+    free(connection->out);
+    free(connection);
+}
+
+static Session *FindSession(Connection *connection, const char *id_text) {
+    char *end;
+    long id = id_text ? strtol(id_text, &end, 10) : -1;
+    if (!id_text || *end || id < 0 || id >= next_id) return NULL;
+    Session *session = sessions[id];
+    return session && session->connection == connection && !session->ended ? session : NULL;
+}
+
+static void HandleLine(Connection *connection, char *line) {
+    char *command = strtok(line, " \t\r");
+    if (!command) return;
+
+    if (strcmp(command, "new") == 0) {
+        Session *session = NewSession(connection);
+        if (session) {
+            Reply(connection, "game %d\n", session->id);
+        } else {
+            Reply(connection, "error out of memory\n");
+        }
+        return;
+    }
+    if (strcmp(command, "stats") == 0) {
+        Reply(connection, "stats %d %d %llu\n", live_sessions, queued_count, (unsigned long long)bot_moves);
+        return;
+    }
+
+    char *id_text = strtok(NULL, " \t\r");
+    Session *session = FindSession(connection, id_text);
+    if (strcmp(command, "move") != 0 && strcmp(command, "board") != 0 && strcmp(command, "end") != 0) {
+        Reply(connection, "error unknown command %s\n", command);
+    } else if (!session) {
+        Reply(connection, "error unknown game %s\n", id_text ? id_text : "");
+    } else if (strcmp(command, "board") == 0) {
+        Reply(connection, "board %d %llu %llu %d\n", session->id, (unsigned long long)session->game.pieces,
+              (unsigned long long)session->game.kings, session->game.current_turn);
+    } else if (strcmp(command, "end") == 0) {
+        Reply(connection, "ended %d\n", session->id);
+        if (session->busy) {
+            session->ended = 1;
+        } else {
+            FreeSession(session);
+        }
+    } else if (session->busy) {
+        Reply(connection, "busy %d\n", session->id);
+    } else {
+        char *text = strtok(NULL, " \t\r"), *time_text = strtok(NULL, " \t\r");
+        CheckersMove move;
+        if (CheckersStatus(&session->game, &session->history) != CHECKERS_PLAYING ||
+            !text || !CheckersParseMove(&session->game, text, &move)) {
+            Reply(connection, "illegal %d\n", session->id);
+            return;
+        }
+        CheckersApply(&session->game, &move, NULL);
+        CheckersHistoryPush(&session->history, &session->game);
+        int status = CheckersStatus(&session->game, &session->history);
+        if (status != CHECKERS_PLAYING) {
+            Reply(connection, "over %d %s\n", session->id, StateName(status));
+            return;
+        }
+
+        Job *job = calloc(1, sizeof(Job));
+        if (!job) {
+            Reply(connection, "error out of memory\n");
+            return;
+        }
+        job->session = session;
+        job->time_ms = time_text ? atoi(time_text) : 0;
+        session->busy = 1;
+        pthread_mutex_lock(&job_lock);
+        JobPush(&queued, job);
+        queued_count++;
+        pthread_cond_signal(&job_ready);
+        pthread_mutex_unlock(&job_lock);
+    }
+}
+
+static int ReadConnection(Connection *connection) {       // 0 once the peer has gone
+    char buffer[READ_SIZE];
+    for (;;) {
+        ssize_t got = recv(connection->fd, buffer, sizeof(buffer), 0);
+        if (got == 0) return 0;
+        if (got < 0) return errno == EAGAIN || errno == EWOULDBLOCK;
+        for (ssize_t i = 0; i < got; i++) {
+            if (buffer[i] == '\n') {
+                connection->in[connection->in_used] = '\0';
+                HandleLine(connection, connection->in);
+                connection->in_used = 0;
+            } else if (connection->in_used < LINE_MAX_LENGTH - 1) {    // Overlong lines are cut
+                connection->in[connection->in_used++] = buffer[i];
+            }
+        }
+    }
+}
+
+static void FinishJobs(int epoll_fd) {        // Plays the bot moves the workers came back with
+    uint64_t count;
+    if (read(done_fd, &count, sizeof(count)) < 0) {}
+    pthread_mutex_lock(&job_lock);
+    Job *jobs = JobTakeAll(&finished);
+    pthread_mutex_unlock(&job_lock);
+
+    while (jobs) {
+        Job *job = jobs;
+        jobs = job->next;
+        Session *session = job->session;
+        session->busy = 0;
+        bot_moves++;
+        if (!session->connection || session->ended) {
+            FreeSession(session);
+        } else {
+            char text[CHECKERS_MOVE_TEXT] = "none";
+            if (job->found) {
+                CheckersApply(&session->game, &job->move, NULL);
+                CheckersHistoryPush(&session->history, &session->game);
+                CheckersFormatMove(&job->move, text);
+            }
+            Reply(session->connection, "bot %d %s %s\n", session->id, text,
+                  StateName(CheckersStatus(&session->game, &session->history)));
+            Flush(epoll_fd, session->connection);
+        }
+        free(job);
+    }
+}
+
+// Event loop
+static int Listen(int port, const char *unix_path) {
+    int fd;
+    if (unix_path) {
+        struct sockaddr_un address = {.sun_family = AF_UNIX};
+        strncpy(address.sun_path, unix_path, sizeof(address.sun_path) - 1);
+        unlink(unix_path);
+        fd = socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK, 0);
+        if (fd < 0 || bind(fd, (struct sockaddr *)&address, sizeof(address)) != 0) return -1;
+    } else {
+        struct sockaddr_in address = {.sin_family = AF_INET, .sin_port = htons(port)};
+        address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        int on = 1;
+        fd = socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK, 0);
+        if (fd < 0) return -1;
+        setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &on, sizeof(on));
+        if (bind(fd, (struct sockaddr *)&address, sizeof(address)) != 0) return -1;
+    }
+    return listen(fd, 4096) == 0 ? fd : -1;
+}
+
+static void AcceptConnections(int epoll_fd, int listen_fd, int tcp) {
+    for (;;) {
+        int fd = accept4(listen_fd, NULL, NULL, SOCK_NONBLOCK);
+        if (fd < 0) return;
+        int on = 1;
+        if (tcp) setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &on, sizeof(on));   // Replies are single short lines
+        Connection *connection = calloc(1, sizeof(Connection));
+        struct epoll_event event = {.events = EPOLLIN | EPOLLRDHUP, .data.ptr = connection};
+        if (!connection || epoll_ctl(epoll_fd, EPOLL_CTL_ADD, fd, &event) != 0) {
+            free(connection);
+            close(fd);
+            continue;
+        }
+        connection->fd = fd;
+    }
+}
+
+int main(int argc, char *argv[]) {
+    CheckersInit();
+    int port = 7000, workers = sysconf(_SC_NPROCESSORS_ONLN);
+    const char *unix_path = NULL, *weights_file = NULL;
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "-port") == 0 && i + 1 < argc) {              // TCP on 127.0.0.1
+            port = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "-unix") == 0 && i + 1 < argc) {       // Unix socket path instead
+            unix_path = argv[++i];
+        } else if (strcmp(argv[i], "-workers") == 0 && i + 1 < argc) {    // Search threads, one engine each
+            workers = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "-time") == 0 && i + 1 < argc) {       // Default budget per bot move
+            server_limits.time_ms = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "-depth") == 0 && i + 1 < argc) {
+            server_limits.max_depth = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "-nodes") == 0 && i + 1 < argc) {
+            server_limits.max_nodes = strtoull(argv[++i], NULL, 10);
+        } else if (strcmp(argv[i], "-hash") == 0 && i + 1 < argc) {       // MB per worker
+            server_hash_mb = strtoull(argv[++i], NULL, 10);
+        } else if (strcmp(argv[i], "-weights") == 0 && i + 1 < argc) {
+            weights_file = argv[++i];
+        } else {
+            printf("Usage: checkers-server [-port n | -unix path] [-workers n] [-time ms] [-depth n] [-nodes n] [-hash MB] [-weights file]\n");
+            return 1;
+        }
+    }
+    CheckersWeights weights;
+    CheckersDefaultWeights(&weights);
+    if (weights_file && !CheckersLoadWeights(weights_file, &weights)) {
+        printf("Error: Could not read weights '%s'\n", weights_file);
+        return 1;
+    }
+    if (workers < 1) workers = 1;
+
+    Worker *pool = calloc(workers, sizeof(Worker));
+    if (!pool) return 1;
+    for (int i = 0; i < workers; i++) {
+        pool[i].engine = CheckersEngineNew(server_hash_mb, 1);
+        if (!pool[i].engine) {
+            printf("Error: Could not allocate %zu MB hash tables\n", server_hash_mb);
+            return 1;
+        }
+        CheckersEngineSetWeights(pool[i].engine, &weights);
+    }
+
+    int listen_fd = Listen(port, unix_path);
+    int epoll_fd = epoll_create1(0);
+    done_fd = eventfd(0, EFD_NONBLOCK);
+    if (listen_fd < 0 || epoll_fd < 0 || done_fd < 0) {
+        if (unix_path) {
+            printf("Error: Could not listen on %s: %s\n", unix_path, strerror(errno));
+        } else {
+            printf("Error: Could not listen on port %d: %s\n", port, strerror(errno));
+        }
+        return 1;
+    }
+    struct epoll_event event = {.events = EPOLLIN, .data.ptr = &listen_fd};
+    epoll_ctl(epoll_fd, EPOLL_CTL_ADD, listen_fd, &event);
+    event.data.ptr = &done_fd;
+    epoll_ctl(epoll_fd, EPOLL_CTL_ADD, done_fd, &event);
+
+    for (int i = 0; i < workers; i++) {
+        if (pthread_create(&pool[i].thread, NULL, WorkerMain, &pool[i]) != 0) {
+            printf("Error: Could not start worker %d\n", i);
+            return 1;
+        }
+    }
+    if (unix_path) {
+        printf("Listening on %s with %d workers\n", unix_path, workers);
+    } else {
+        printf("Listening on 127.0.0.1:%d with %d workers\n", port, workers);
+    }
+    fflush(stdout);
+
+    struct epoll_event events[256];
+    for (;;) {
+        int count = epoll_wait(epoll_fd, events, 256, -1);
+        if (count < 0 && errno != EINTR) break;
+        for (int i = 0; i < count; i++) {
+            if (events[i].data.ptr == &listen_fd) {
+                AcceptConnections(epoll_fd, listen_fd, !unix_path);
+                continue;
+            }
+            if (events[i].data.ptr == &done_fd) {
+                FinishJobs(epoll_fd);
+                continue;
+            }
+            Connection *connection = events[i].data.ptr;
+            int open = 1;
+            if (events[i].events & (EPOLLIN | EPOLLRDHUP | EPOLLHUP | EPOLLERR)) open = ReadConnection(connection);
+            if (!open) {
+                CloseConnection(epoll_fd, connection);
+                continue;
+            }
+            Flush(epoll_fd, connection);
+        }
+    }
+    return 1;
+}